@@ -0,0 +1,138 @@
+#include <Bench.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+static std::atomic<size_t> allocBytes(0);
+static std::atomic<size_t> allocCount(0);
+
+static inline void recordAllocation(size_t size) {
+  allocBytes.fetch_add(size, std::memory_order_relaxed);
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef BENCH_WRAP_MALLOC
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so that ArduinoJson's DefaultAllocator is counted too.
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  recordAllocation(size);
+  return __real_malloc(size);
+}
+void* __wrap_calloc(size_t n, size_t size) {
+  recordAllocation(n * size);
+  return __real_calloc(n, size);
+}
+void* __wrap_realloc(void* ptr, size_t size) {
+  recordAllocation(size);
+  return __real_realloc(ptr, size);
+}
+}
+#define BENCH_RAW_MALLOC __real_malloc
+#else
+#define BENCH_RAW_MALLOC malloc
+#endif
+
+void* operator new(size_t size) {
+  recordAllocation(size);
+  void* ptr = BENCH_RAW_MALLOC(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+size_t AllocStats::bytes() {
+  return allocBytes.load(std::memory_order_relaxed);
+}
+
+size_t AllocStats::count() {
+  return allocCount.load(std::memory_order_relaxed);
+}
+
+struct BenchEntry {
+  const char* name;
+  Bench::BenchFn fn;
+  uint32_t iterations;
+};
+
+static std::vector<BenchEntry>& entries() {
+  static std::vector<BenchEntry> registered;
+  return registered;
+}
+
+static std::vector<BenchResult>& resultList() {
+  static std::vector<BenchResult> results;
+  return results;
+}
+
+void Bench::add(const char* name, BenchFn fn, uint32_t iterations) {
+  entries().push_back({name, fn, iterations ? iterations : 1});
+}
+
+const std::vector<BenchResult>& Bench::results() {
+  return resultList();
+}
+
+size_t Bench::runAll(const char* filter) {
+  printf("%-48s %10s %12s %12s %10s\n", "benchmark", "iterations", "ns/op", "B/op", "allocs/op");
+  for (BenchEntry& entry : entries()) {
+    if (filter && !strstr(entry.name, filter)) {
+      continue;
+    }
+
+    uint32_t warmup = entry.iterations / 10 + 1;
+    for (uint32_t i = 0; i < warmup; i++) {
+      entry.fn();
+    }
+
+    size_t bytesBefore = AllocStats::bytes();
+    size_t countBefore = AllocStats::count();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < entry.iterations; i++) {
+      entry.fn();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    BenchResult result;
+    result.name = entry.name;
+    result.iterations = entry.iterations;
+    result.nsPerOp = (double)elapsed.count() / entry.iterations;
+    result.bytesPerOp = (double)(AllocStats::bytes() - bytesBefore) / entry.iterations;
+    result.allocsPerOp = (double)(AllocStats::count() - countBefore) / entry.iterations;
+    resultList().push_back(result);
+
+    printf("%-48s %10u %12.1f %12.1f %10.2f\n",
+           result.name,
+           result.iterations,
+           result.nsPerOp,
+           result.bytesPerOp,
+           result.allocsPerOp);
+    fflush(stdout);
+  }
+  return resultList().size();
+}
@@ -0,0 +1,39 @@
+#ifndef Bench_h
+#define Bench_h
+
+#include <Arduino.h>
+
+#include <functional>
+#include <vector>
+
+// Micro-benchmark runner for the native build. Every benchmark is a closure executed `iterations` times after a short
+// warm-up; wall time and heap traffic (operator new plus, when BENCH_WRAP_MALLOC is set, malloc/calloc/realloc) are
+// reported per operation.
+
+struct BenchResult {
+  const char* name;
+  uint32_t iterations;
+  double nsPerOp;
+  double bytesPerOp;
+  double allocsPerOp;
+};
+
+class Bench {
+ public:
+  typedef std::function<void()> BenchFn;
+
+  static void add(const char* name, BenchFn fn, uint32_t iterations = 10000);
+
+  // runs every registered benchmark whose name contains filter (all when filter is null), returns the result count
+  static size_t runAll(const char* filter = nullptr);
+
+  static const std::vector<BenchResult>& results();
+};
+
+// Counters fed by the allocation hooks in Bench.cpp
+struct AllocStats {
+  static size_t bytes();
+  static size_t count();
+};
+
+#endif  // end Bench_h
@@ -0,0 +1,158 @@
+#ifndef BenchStates_h
+#define BenchStates_h
+
+#include <StatefulService.h>
+#include <FieldBindings.h>
+#include <FormStream.h>
+
+// State types exercised by the benchmarks. BenchSettings has the shape of the small framework settings (NTP, OTA,
+// MQTT) and BenchFormState reproduces the REST form and WS status payloads of src/LightStateService.h, so the numbers
+// track what the device actually serializes. Logging is left out of the updaters.
+
+class BenchSettings {
+ public:
+  bool enabled;
+  String tzLabel;
+  String tzFormat;
+  String server;
+
+  static void read(const BenchSettings& settings, JsonObject& root) {
+    root["enabled"] = settings.enabled;
+    root["server"] = settings.server;
+    root["tz_label"] = settings.tzLabel;
+    root["tz_format"] = settings.tzFormat;
+  }
+
+  static StateUpdateResult update(JsonObject& root, BenchSettings& settings) {
+    settings.enabled = root["enabled"] | true;
+    settings.server = root["server"] | "time.google.com";
+    settings.tzLabel = root["tz_label"] | "Europe/London";
+    settings.tzFormat = root["tz_format"] | "GMT0BST,M3.5.0/1,M10.5.0";
+    return StateUpdateResult::CHANGED;
+  }
+};
+
+class BenchFormState {
+ public:
+  bool ledOn{false};
+  float monthlyConsumptionLimit{0.0f};
+  float dailyConsumptionLimit{0.0f};
+  int testNumber{0};
+  int testDropdown{2};
+  int gain{20};
+  String testText;
+  String textArea{"Millis are: "};
+
+  static void read(const BenchFormState& s, JsonObject& root) {
+    FormDocumentWriter form(root);
+    forms(s, form);
+  }
+
+  static void stream(const BenchFormState& s, FormStreamWriter& form) {
+    forms(s, form);
+  }
+
+  // WS status payload: one merged trend point with 21 keys plus the test fields
+  static void readSta(const BenchFormState& st, JsonObject& root) {
+    static double phase = 0.0;
+    phase += 1.0;
+    JsonArray trendArr = root.createNestedArray("trend_data");
+    JsonObject pt = trendArr.createNestedObject();
+    pt["timestamp"] = (unsigned long)(phase * 1000);
+    static const char* const keys[] = {"key1",  "key2",  "key3",  "key4",  "key5",  "key6",  "key7",
+                                       "key8",  "key9",  "key10", "key11", "key12", "key13", "key14",
+                                       "key15", "key16", "key17", "key18", "key19", "key20", "key21"};
+    for (uint8_t i = 0; i < 21; i++) {
+      double a = 50.0 + 10.0 * i;
+      pt[keys[i]] = a * sin(0.2 * phase + i * 0.7);
+    }
+    root["test_text"] = st.testText;
+    root["test_number"] = st.testNumber;
+    root["test_checkbox"] = st.ledOn;
+    root["test_switch"] = !st.ledOn;
+    root["test_textarea"] = st.textArea;
+    root["test_dropdown"] = st.testDropdown;
+  }
+
+  static StateUpdateResult update(JsonObject& root, BenchFormState& s) {
+    bool stateChanged = false;
+    stateChanged |= FormBuilder::updateValue(root, "test_text", s.testText);
+    stateChanged |= FormBuilder::updateValue(root, "monthly_consumption_limit", s.monthlyConsumptionLimit);
+    stateChanged |= FormBuilder::updateValue(root, "daily_consumption_limit", s.dailyConsumptionLimit);
+    stateChanged |= FormBuilder::updateValue(root, "led_on", s.ledOn);
+    stateChanged |= FormBuilder::updateValue(root, "test_number", s.testNumber);
+    stateChanged |= FormBuilder::updateValue(root, "test_dropdown", s.testDropdown);
+    stateChanged |= FormBuilder::updateValue(root, "test_textarea", s.textArea);
+    stateChanged |= FormBuilder::updateValue(root, "gain", s.gain);
+    return stateChanged ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
+  }
+
+  // the same keys as update(), dispatched through a FieldTable
+  static StateUpdateResult updateBound(JsonObject& root, BenchFormState& s) {
+    return fields().update(root, s);
+  }
+
+  static const FieldTable<BenchFormState>& fields() {
+    static const FieldBinding<BenchFormState> bindings[] = {
+        {"test_text", &BenchFormState::testText, 1u << 0},
+        {"monthly_consumption_limit", &BenchFormState::monthlyConsumptionLimit, 1u << 1},
+        {"daily_consumption_limit", &BenchFormState::dailyConsumptionLimit, 1u << 2},
+        {"led_on", &BenchFormState::ledOn, 1u << 3},
+        {"test_number", &BenchFormState::testNumber, 1u << 4},
+        {"test_dropdown", &BenchFormState::testDropdown, 1u << 5},
+        {"test_textarea", &BenchFormState::textArea, 1u << 6},
+        {"gain", &BenchFormState::gain, 1u << 7},
+    };
+    static const FieldTable<BenchFormState> table(bindings);
+    return table;
+  }
+
+ private:
+  template <class Form>
+  static void forms(const BenchFormState& s, Form& form) {
+    addForm(s, form, "status", "Status Form");
+    addForm(s, form, "settings", "Settings Form");
+  }
+
+  template <class Form>
+  static void addForm(const BenchFormState& s, Form& f, const char* name, const char* description) {
+    f.createForm(name, description);
+    f.addTrendField("trend_data", AF::RW,
+      lines(line("key1", hidden, "#8884d8", "monotone"),
+            line("key2", hidden, "#FF0000", "monotone"),
+            line("key3", hidden, "#FF00FF", "monotone")),
+      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("lineChart"));
+    f.addTrendField("trend_data", AF::RW,
+      lines(line("key1", hidden, "#8884d8", "monotone"),
+            line("key2", hidden, "#FF0000", "monotone"),
+            line("key3", hidden, "#FF00FF", "monotone")),
+      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("barChart"));
+    f.addTrendField("trend_data", AF::RW,
+      lines(line("key1",  visible, "#8884d8", "monotone"),
+            line("key2",  hidden,  "#FF0000", "step"),
+            line("key3",  visible, "#FF00FF", "monotone"),
+            line("key21", visible, "#556B2F", "monotone")),
+      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("pieChart"));
+
+    f.addSwitchField  ("led_on",       AF::RW, s.ledOn);
+    f.addSwitchField  ("led_on",       AF::R,  s.ledOn);
+    f.addTextField    ("test_text",    AF::RW, "Sample text from Medved");
+    f.addTextField    ("test_text",    AF::R,  "Sample text from Medved");
+    f.addNumberField  ("test_number",  AF::RW, (double)s.testNumber, minVal(0), maxVal(100), format("0.00"));
+    f.addNumberField  ("test_number",  AF::R,  (double)s.testNumber, minVal(0), maxVal(100), format("0.00"));
+    f.addCheckboxField("test_checkbox",AF::RW, s.ledOn);
+    f.addCheckboxField("test_checkbox",AF::R,  s.ledOn);
+    f.addSwitchField  ("test_switch",  AF::RW, s.ledOn);
+    f.addSwitchField  ("test_switch",  AF::R,  s.ledOn);
+    f.addDropdownField("test_dropdown",AF::RW, s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option",3));
+    f.addDropdownField("test_dropdown",AF::R,  s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option",3));
+    f.addRadioField   ("test_dropdown",AF::RW, s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option bla bla bla",3));
+    f.addRadioField   ("test_dropdown",AF::R,  s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option bla bla bla",3));
+    f.addTextareaField("test_textarea",AF::RW, s.textArea);
+    f.addTextareaField("test_textarea",AF::R,  s.textArea);
+    f.addSliderField  ("gain",        AF::RW, s.gain, minVal(10), maxVal(60));
+    f.addSliderField  ("gain",        AF::R,  s.gain, minVal(10), maxVal(60));
+  }
+};
+
+#endif  // end BenchStates_h
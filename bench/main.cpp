@@ -0,0 +1,264 @@
+#include <Bench.h>
+#include <BenchStates.h>
+
+#include <FSPersistence.h>
+#include <HttpEndpoint.h>
+#include <NewMultiWsService.h>
+#include <LittleFS.h>
+
+// Host benchmarks for the framework hot paths. Build and run with:
+//
+//   pio run -e native -t exec                 (all benchmarks)
+//   .pio/build/native/program ws.            (only names containing "ws.")
+//
+// Every line reports wall time, heap bytes and heap allocations per operation.
+
+#define BENCH_WS_CLIENTS 4
+
+static AsyncWebServer server(80);
+
+static StatefulService<BenchSettings> settingsService;
+static StatefulService<BenchFormState> formService;
+
+static FSPersistence<BenchSettings> settingsPersistence(BenchSettings::read,
+                                                        BenchSettings::update,
+                                                        &settingsService,
+                                                        &LittleFS,
+                                                        "/config/benchSettings.json");
+static FSPersistence<BenchFormState> formPersistence(BenchFormState::read,
+                                                     BenchFormState::update,
+                                                     &formService,
+                                                     &LittleFS,
+                                                     "/config/benchForm.json");
+
+static HttpEndpoint<BenchSettings> settingsEndpoint(BenchSettings::read,
+                                                    BenchSettings::update,
+                                                    &settingsService,
+                                                    &server,
+                                                    "/rest/benchSettings");
+static HttpEndpoint<BenchFormState> formEndpoint(BenchFormState::read,
+                                                 BenchFormState::update,
+                                                 &formService,
+                                                 &server,
+                                                 "/rest/benchForm");
+
+static FormStreamEndpoint<BenchFormState> formStreamEndpoint(BenchFormState::stream,
+                                                             &formService,
+                                                             &server,
+                                                             "/rest/benchFormStream");
+
+static MultiWsManager wsManager(&server);
+
+static void registerStatefulServiceBenchmarks() {
+  Bench::add("StatefulService.update(lambda)", []() {
+    settingsService.update(
+        [](BenchSettings& settings) {
+          settings.enabled = !settings.enabled;
+          return StateUpdateResult::CHANGED;
+        },
+        "bench");
+  });
+
+  Bench::add("StatefulService.update(json)", []() {
+    StaticJsonDocument<256> doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["enabled"] = true;
+    root["server"] = "pool.ntp.org";
+    settingsService.update(root, BenchSettings::update, "bench");
+  });
+
+  Bench::add("StatefulService.read(lambda)", []() {
+    bool enabled = false;
+    settingsService.read([&](BenchSettings& settings) { enabled = settings.enabled; });
+    (void)enabled;
+  });
+
+  Bench::add("StatefulService.read(json)", []() {
+    StaticJsonDocument<256> doc;
+    JsonObject root = doc.to<JsonObject>();
+    settingsService.read(root, BenchSettings::read);
+  });
+
+  static StatefulService<BenchSettings> snapshotService;
+  snapshotService.enableSnapshots();
+
+  Bench::add("StatefulService.update(lambda,snapshot)", []() {
+    snapshotService.update(
+        [](BenchSettings& settings) {
+          settings.enabled = !settings.enabled;
+          return StateUpdateResult::CHANGED;
+        },
+        "bench");
+  });
+
+  Bench::add("StatefulService.read(json,snapshot)", []() {
+    StaticJsonDocument<256> doc;
+    JsonObject root = doc.to<JsonObject>();
+    snapshotService.read(root, BenchSettings::read);
+  });
+}
+
+static void registerPersistenceBenchmarks() {
+  // the update handlers would otherwise write on every StatefulService benchmark
+  settingsPersistence.disableUpdateHandler();
+  formPersistence.disableUpdateHandler();
+
+  // unchanged state: the content hash matches and the write is skipped
+  Bench::add("FSPersistence.writeToFS(settings)", []() { settingsPersistence.writeToFS(); }, 2000);
+  Bench::add("FSPersistence.writeToFS(settings,changed)", []() {
+    settingsService.updateWithoutPropagation([](BenchSettings& settings) {
+      settings.enabled = !settings.enabled;
+      return StateUpdateResult::CHANGED;
+    });
+    settingsPersistence.writeToFS();
+  }, 2000);
+  Bench::add("FSPersistence.writeToFS(form)", []() { formPersistence.writeToFS(); }, 500);
+  Bench::add("FSPersistence.readFromFS(settings)", []() { settingsPersistence.readFromFS(); }, 2000);
+
+  // the same change appended to a ConfigStore log instead of rewriting the file
+  static ConfigStore benchStore(&LittleFS, "/config/benchStore.log");
+  benchStore.begin();
+  Bench::add("FSPersistence.writeToFS(settings,changed,store)", []() {
+    ConfigStore::setDefault(&benchStore);
+    settingsService.updateWithoutPropagation([](BenchSettings& settings) {
+      settings.enabled = !settings.enabled;
+      return StateUpdateResult::CHANGED;
+    });
+    settingsPersistence.writeToFS();
+    ConfigStore::setDefault(nullptr);
+  }, 2000);
+
+  // the same form state stored as MessagePack
+  static FSPersistence<BenchFormState> packedPersistence(
+      BenchFormState::read, BenchFormState::update, &formService, &LittleFS, "/config/benchPacked.json");
+  packedPersistence.disableUpdateHandler();
+  packedPersistence.setFormat(FSPersistenceFormat::MSGPACK);
+  packedPersistence.readFromFS();
+  Bench::add("FSPersistence.writeToFS(form,msgpack)", []() {
+    formService.updateWithoutPropagation([](BenchFormState& state) {
+      state.gain = state.gain >= 60 ? 10 : state.gain + 1;
+      return StateUpdateResult::CHANGED;
+    });
+    packedPersistence.writeToFS();
+  }, 500);
+  Bench::add("FSPersistence.readFromFS(form,msgpack)", []() { packedPersistence.readFromFS(); }, 500);
+
+  // a slider drag: every update is propagated, the worker coalesces them into a single write
+  static StatefulService<BenchFormState> dragService;
+  static FSPersistence<BenchFormState> dragPersistence(
+      BenchFormState::read, BenchFormState::update, &dragService, &LittleFS, "/config/benchDrag.json");
+  Bench::add("FSPersistence.update(write-behind)", []() {
+    dragService.update(
+        [](BenchFormState& state) {
+          state.gain = state.gain >= 60 ? 10 : state.gain + 1;
+          return StateUpdateResult::CHANGED;
+        },
+        "bench");
+  });
+}
+
+static void registerHttpBenchmarks() {
+  Bench::add("HttpEndpoint.GET(settings)", []() {
+    AsyncWebServerRequest request(HTTP_GET, "/rest/benchSettings");
+    server.handle(&request);
+  });
+
+  Bench::add("HttpEndpoint.GET(form)", []() {
+    AsyncWebServerRequest request(HTTP_GET, "/rest/benchForm");
+    server.handle(&request);
+  }, 1000);
+
+  Bench::add("HttpEndpoint.GET(form,status)", []() {
+    AsyncWebServerRequest request(HTTP_GET, "/rest/benchForm?form=status");
+    server.handle(&request);
+  }, 1000);
+
+  Bench::add("FormStreamEndpoint.GET(form)", []() {
+    AsyncWebServerRequest request(HTTP_GET, "/rest/benchFormStream");
+    server.handle(&request);
+  }, 1000);
+
+  Bench::add("HttpEndpoint.POST(settings)", []() {
+    AsyncWebServerRequest request(HTTP_POST, "/rest/benchSettings", "{\"enabled\":true,\"server\":\"pool.ntp.org\"}");
+    server.handle(&request);
+    request.finish();
+  });
+
+  Bench::add("HttpEndpoint.POST(form)", []() {
+    static int gain = 10;
+    gain = gain >= 60 ? 10 : gain + 1;
+    String body = "{\"gain\":" + String(gain) + ",\"test_text\":\"bench\"}";
+    AsyncWebServerRequest request(HTTP_POST, "/rest/benchForm", body);
+    server.handle(&request);
+    request.finish();
+  }, 1000);
+}
+
+static void registerWsBenchmarks() {
+  static ws_endpoint_t endpoint =
+      wsManager.addEndpoint<BenchFormState>("/ws/bench", &formService, BenchFormState::readSta, BenchFormState::update);
+  AsyncWebServerRequest probe(HTTP_GET, "/ws/bench");
+  for (AsyncWebHandler* handler : server.handlers()) {
+    AsyncWebSocket* ws = dynamic_cast<AsyncWebSocket*>(handler);
+    if (ws && ws->canHandle(&probe)) {
+      for (int i = 0; i < BENCH_WS_CLIENTS; i++) {
+        ws->connect();
+      }
+    }
+  }
+
+  Bench::add("ws.broadcastCurrentState", []() {
+    wsManager.broadcastCurrentState(endpoint, "bench");
+    wsManager.processAllQueues();
+  });
+}
+
+static void registerFormBuilderBenchmarks() {
+  static DynamicJsonDocument updateDoc(512);
+  deserializeJson(updateDoc,
+                  "{\"test_text\":\"bench\",\"monthly_consumption_limit\":120.5,\"daily_consumption_limit\":4.5,"
+                  "\"led_on\":true,\"test_number\":7,\"test_dropdown\":3,\"test_textarea\":\"area\",\"gain\":42}");
+
+  Bench::add("FormBuilder.updateValue(form)", []() {
+    JsonObject root = updateDoc.as<JsonObject>();
+    BenchFormState state;
+    BenchFormState::update(root, state);
+  });
+
+  Bench::add("FieldTable.update(form)", []() {
+    JsonObject root = updateDoc.as<JsonObject>();
+    BenchFormState state;
+    BenchFormState::updateBound(root, state);
+  });
+
+  Bench::add("FormBuilder.read(form)", []() {
+    DynamicJsonDocument doc(DEFAULT_BUFFER_SIZE);
+    JsonObject root = doc.to<JsonObject>();
+    BenchFormState state;
+    BenchFormState::read(state, root);
+  }, 2000);
+
+  Bench::add("FormBuilder.read+serialize(form)", []() {
+    DynamicJsonDocument doc(DEFAULT_BUFFER_SIZE);
+    JsonObject root = doc.to<JsonObject>();
+    BenchFormState state;
+    BenchFormState::read(state, root);
+    String out;
+    serializeJson(doc, out);
+  }, 2000);
+}
+
+int main(int argc, char** argv) {
+  Serial.setQuiet(true);
+  LittleFS.begin(true);
+  settingsPersistence.readFromFS();
+  formPersistence.readFromFS();
+
+  registerStatefulServiceBenchmarks();
+  registerPersistenceBenchmarks();
+  registerHttpBenchmarks();
+  registerWsBenchmarks();
+  registerFormBuilderBenchmarks();
+
+  return Bench::runAll(argc > 1 ? argv[1] : nullptr) > 0 ? 0 : 1;
+}
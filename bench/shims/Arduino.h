@@ -0,0 +1,197 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// Minimal host implementation of the Arduino core used by the native benchmark build. Time is taken from the host
+// steady clock, Serial writes to stdout and PROGMEM helpers are no-ops.
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+
+#include <WString.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+inline void pinMode(uint8_t, uint8_t) {
+}
+inline void digitalWrite(uint8_t, uint8_t) {
+}
+inline int digitalRead(uint8_t) {
+  return LOW;
+}
+
+class Print {
+ public:
+  virtual ~Print() {
+  }
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+      n += write(*buffer++);
+    }
+    return n;
+  }
+  size_t write(const char* str) {
+    return str ? write((const uint8_t*)str, strlen(str)) : 0;
+  }
+  size_t write(const char* buffer, size_t size) {
+    return write((const uint8_t*)buffer, size);
+  }
+
+  size_t print(const String& s) {
+    return write(s.c_str(), s.length());
+  }
+  size_t print(const char* s) {
+    return write(s);
+  }
+  size_t print(const __FlashStringHelper* s) {
+    return write(reinterpret_cast<const char*>(s));
+  }
+  size_t print(char c) {
+    return write((uint8_t)c);
+  }
+  template <typename V>
+  size_t print(V value) {
+    return print(String(value));
+  }
+  size_t println() {
+    return write("\r\n");
+  }
+  template <typename V>
+  size_t println(V value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return len > 0 ? write(buf, std::min((size_t)len, sizeof(buf) - 1)) : 0;
+  }
+  size_t printf_P(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    return len > 0 ? write(buf, std::min((size_t)len, sizeof(buf) - 1)) : 0;
+  }
+  virtual void flush() {
+  }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) {
+    _timeout = timeout;
+  }
+  size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = read();
+      if (c < 0) {
+        break;
+      }
+      buffer[count++] = (char)c;
+    }
+    return count;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) {
+    return readBytes((char*)buffer, length);
+  }
+  String readStringUntil(char terminator) {
+    String ret;
+    int c;
+    while ((c = read()) >= 0 && c != terminator) {
+      ret.concat((char)c);
+    }
+    return ret;
+  }
+
+ protected:
+  unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {
+  }
+  size_t write(uint8_t c) override {
+    return _quiet ? 1 : fwrite(&c, 1, 1, stdout);
+  }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    return _quiet ? size : fwrite(buffer, 1, size, stdout);
+  }
+  using Print::write;
+  int available() override {
+    return 0;
+  }
+  int read() override {
+    return -1;
+  }
+  int peek() override {
+    return -1;
+  }
+  // the benchmark silences framework logging so it does not dominate the measurements
+  void setQuiet(bool quiet) {
+    _quiet = quiet;
+  }
+
+ private:
+  bool _quiet = false;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+ public:
+  void restart() {
+  }
+  uint32_t getFreeHeap() {
+    return 0;
+  }
+  uint32_t getMaxAllocHeap() {
+    return 0;
+  }
+};
+
+extern EspClass ESP;
+
+#endif  // end Arduino_h
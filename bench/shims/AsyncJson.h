@@ -0,0 +1,83 @@
+#ifndef AsyncJson_h
+#define AsyncJson_h
+
+// ArduinoJson glue of the fake AsyncWebServer, matching the ArduinoJson 6 flavour of the ESPAsyncWebServer 3.x API.
+
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+#define JSON_MIMETYPE "application/json"
+
+typedef std::function<void(AsyncWebServerRequest* request, JsonVariant& json)> ArJsonRequestHandlerFunction;
+
+class AsyncJsonResponse : public AsyncWebServerResponse {
+ public:
+  AsyncJsonResponse(bool isArray = false, size_t maxJsonBufferSize = 1024) :
+      AsyncWebServerResponse(200, JSON_MIMETYPE), _jsonBuffer(maxJsonBufferSize) {
+    if (isArray) {
+      _root = _jsonBuffer.createNestedArray();
+    } else {
+      _root = _jsonBuffer.createNestedObject();
+    }
+  }
+
+  JsonVariant& getRoot() {
+    return _root;
+  }
+  size_t setLength() {
+    _contentLength = measureJson(_root);
+    return _contentLength;
+  }
+  void render(String& out) override {
+    serializeJson(_root, out);
+  }
+
+ private:
+  DynamicJsonDocument _jsonBuffer;
+  JsonVariant _root;
+};
+
+class AsyncCallbackJsonWebHandler : public AsyncWebHandler {
+ public:
+  AsyncCallbackJsonWebHandler(const String& uri,
+                              ArJsonRequestHandlerFunction onRequest = nullptr,
+                              size_t maxJsonBufferSize = 16384) :
+      _uri(uri), _onRequest(onRequest), _maxJsonBufferSize(maxJsonBufferSize) {
+  }
+
+  void setMethod(WebRequestMethodComposite method) {
+    _method = method;
+  }
+  void setMaxContentLength(int maxContentLength) {
+    _maxContentLength = maxContentLength;
+  }
+  void onRequest(ArJsonRequestHandlerFunction fn) {
+    _onRequest = fn;
+  }
+
+  bool canHandle(AsyncWebServerRequest* request) override {
+    return (request->method() & _method) && request->url() == _uri;
+  }
+  void handleRequest(AsyncWebServerRequest* request) override {
+    if ((int)request->body().length() > _maxContentLength) {
+      request->send(413);
+      return;
+    }
+    DynamicJsonDocument jsonBuffer(_maxJsonBufferSize);
+    if (deserializeJson(jsonBuffer, request->body().c_str(), request->body().length()) != DeserializationError::Ok) {
+      request->send(400);
+      return;
+    }
+    JsonVariant json = jsonBuffer.as<JsonVariant>();
+    _onRequest(request, json);
+  }
+
+ private:
+  String _uri;
+  ArJsonRequestHandlerFunction _onRequest;
+  size_t _maxJsonBufferSize;
+  WebRequestMethodComposite _method = HTTP_POST | HTTP_PUT | HTTP_PATCH;
+  int _maxContentLength = 16384;
+};
+
+#endif  // end AsyncJson_h
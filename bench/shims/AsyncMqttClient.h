@@ -0,0 +1,82 @@
+#ifndef AsyncMqttClient_h
+#define AsyncMqttClient_h
+
+// Fake MQTT client: publishes are counted, connection state is controlled by the benchmark.
+
+#include <Arduino.h>
+
+#include <vector>
+
+struct AsyncMqttClientMessageProperties {
+  uint8_t qos;
+  bool dup;
+  bool retain;
+};
+
+class AsyncMqttClient {
+ public:
+  typedef std::function<void(bool sessionPresent)> OnConnectUserCallback;
+  typedef std::function<void(char* topic,
+                             char* payload,
+                             AsyncMqttClientMessageProperties properties,
+                             size_t len,
+                             size_t index,
+                             size_t total)>
+      OnMessageUserCallback;
+
+  AsyncMqttClient& onConnect(std::function<void()> callback) {
+    _onConnect.push_back([callback](bool) { callback(); });
+    return *this;
+  }
+  AsyncMqttClient& onConnect(OnConnectUserCallback callback) {
+    _onConnect.push_back(callback);
+    return *this;
+  }
+  AsyncMqttClient& onMessage(OnMessageUserCallback callback) {
+    _onMessage.push_back(callback);
+    return *this;
+  }
+
+  bool connected() const {
+    return _connected;
+  }
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, const char* payload = nullptr, size_t length = 0) {
+    published++;
+    publishedBytes += payload ? (length ? length : strlen(payload)) : 0;
+    return 1;
+  }
+  uint16_t subscribe(const char* topic, uint8_t qos) {
+    return 1;
+  }
+  uint16_t unsubscribe(const char* topic) {
+    return 1;
+  }
+
+  // bench helpers
+  void setConnected(bool connected) {
+    _connected = connected;
+    if (connected) {
+      for (auto& cb : _onConnect) {
+        cb(false);
+      }
+    }
+  }
+  void deliver(const char* topic, const char* payload) {
+    String t(topic);
+    String p(payload);
+    AsyncMqttClientMessageProperties properties = {0, false, false};
+    for (auto& cb : _onMessage) {
+      cb(t.begin(), p.begin(), properties, p.length(), 0, p.length());
+    }
+  }
+
+  size_t published = 0;
+  size_t publishedBytes = 0;
+
+ private:
+  bool _connected = false;
+  std::vector<OnConnectUserCallback> _onConnect;
+  std::vector<OnMessageUserCallback> _onMessage;
+};
+
+#endif  // end AsyncMqttClient_h
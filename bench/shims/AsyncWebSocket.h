@@ -0,0 +1,320 @@
+#ifndef AsyncWebSocket_h
+#define AsyncWebSocket_h
+
+// Fake AsyncWebSocket following the shared-buffer API of ESPAsyncWebServer 3.x. Clients are in-process objects that
+// count the frames and bytes queued to them; the benchmarks connect clients and inject frames through the helpers at
+// the bottom of AsyncWebSocket.
+
+#include <ESPAsyncWebServer.h>
+
+#include <list>
+#include <memory>
+#include <vector>
+
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+typedef enum { WS_DISCONNECTED, WS_CONNECTED, WS_DISCONNECTING } AwsClientStatus;
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PING, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+typedef std::shared_ptr<std::vector<uint8_t>> AsyncWebSocketSharedBuffer;
+
+class AsyncWebSocket;
+class AsyncWebSocketClient;
+
+class AsyncClient {
+ public:
+  bool canSend() const {
+    return true;
+  }
+  size_t space() const {
+    return 5744;
+  }
+};
+
+class AsyncWebSocketMessageBuffer {
+ public:
+  explicit AsyncWebSocketMessageBuffer(size_t size) : _buffer(std::make_shared<std::vector<uint8_t>>(size + 1)) {
+    _buffer->resize(size);
+  }
+  uint8_t* get() const {
+    return _buffer->data();
+  }
+  size_t length() const {
+    return _buffer->size();
+  }
+
+ private:
+  friend class AsyncWebSocket;
+  friend class AsyncWebSocketClient;
+  AsyncWebSocketSharedBuffer _buffer;
+};
+
+class AsyncWebSocketMessage {
+ public:
+  AsyncWebSocketMessage(AsyncWebSocketSharedBuffer buffer, uint8_t opcode = WS_TEXT, bool mask = false) :
+      _buffer(buffer), _opcode(opcode) {
+  }
+  virtual ~AsyncWebSocketMessage() {
+  }
+  size_t send(AsyncClient* client) {
+    return _buffer ? _buffer->size() : 0;
+  }
+
+ private:
+  AsyncWebSocketSharedBuffer _buffer;
+  uint8_t _opcode;
+};
+
+typedef std::function<
+    void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len)>
+    AwsEventHandler;
+
+class AsyncWebSocketClient {
+ public:
+  AsyncWebSocketClient(AsyncWebSocket* server, uint32_t id) : _server(server), _id(id) {
+  }
+
+  uint32_t id() const {
+    return _id;
+  }
+  AwsClientStatus status() const {
+    return _status;
+  }
+  AsyncClient* client() {
+    return &_client;
+  }
+  AsyncWebSocket* server() {
+    return _server;
+  }
+  bool canSend() const {
+    return _status == WS_CONNECTED && _queued < _queueLimit;
+  }
+  bool queueIsFull() const {
+    return !canSend();
+  }
+  size_t queueLen() const {
+    return _queued;
+  }
+  void setCloseClientOnQueueFull(bool close) {
+  }
+  void close(uint16_t code = 0, const char* message = nullptr);
+  bool ping(const uint8_t* data = nullptr, size_t len = 0) {
+    return true;
+  }
+
+  bool text(AsyncWebSocketSharedBuffer buffer) {
+    return queue(buffer ? buffer->size() : 0);
+  }
+  bool text(AsyncWebSocketMessageBuffer* buffer) {
+    bool queued = buffer && text(buffer->_buffer);
+    delete buffer;
+    return queued;
+  }
+  bool text(const char* message, size_t len) {
+    return text(std::make_shared<std::vector<uint8_t>>(message, message + len));
+  }
+  bool text(const char* message) {
+    return text(message, strlen(message));
+  }
+  bool text(const String& message) {
+    return text(message.c_str(), message.length());
+  }
+  bool binary(AsyncWebSocketSharedBuffer buffer) {
+    return text(buffer);
+  }
+  bool binary(AsyncWebSocketMessageBuffer* buffer) {
+    return text(buffer);
+  }
+  bool binary(const uint8_t* message, size_t len) {
+    return text((const char*)message, len);
+  }
+
+  // bench helpers: traffic accounting and back-pressure simulation
+  size_t framesSent() const {
+    return _frames;
+  }
+  size_t bytesSent() const {
+    return _bytes;
+  }
+  void setQueueLimit(size_t limit) {
+    _queueLimit = limit;
+  }
+  void drain() {
+    _queued = 0;
+  }
+
+ private:
+  friend class AsyncWebSocket;
+
+  AsyncWebSocket* _server;
+  uint32_t _id;
+  AwsClientStatus _status = WS_CONNECTED;
+  AsyncClient _client;
+  size_t _frames = 0;
+  size_t _bytes = 0;
+  size_t _queued = 0;
+  size_t _queueLimit = 32;
+
+  bool queue(size_t len) {
+    if (_status != WS_CONNECTED || _queued >= _queueLimit) {
+      return false;
+    }
+    _frames++;
+    _bytes += len;
+    // the fake TCP stack delivers immediately unless a limit has been configured to emulate a slow link
+    if (_queueLimit < 32) {
+      _queued++;
+    }
+    return true;
+  }
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+ public:
+  explicit AsyncWebSocket(const String& url) : _url(url) {
+  }
+
+  const char* url() const {
+    return _url.c_str();
+  }
+  void onEvent(AwsEventHandler handler) {
+    _handler = handler;
+  }
+  bool canHandle(AsyncWebServerRequest* request) override {
+    return request->url() == _url;
+  }
+
+  size_t count() const {
+    size_t n = 0;
+    for (const AsyncWebSocketClient& c : _clients) {
+      n += c.status() == WS_CONNECTED ? 1 : 0;
+    }
+    return n;
+  }
+  std::list<AsyncWebSocketClient>& getClients() {
+    return _clients;
+  }
+  AsyncWebSocketClient* client(uint32_t id) {
+    for (AsyncWebSocketClient& c : _clients) {
+      if (c.id() == id && c.status() == WS_CONNECTED) {
+        return &c;
+      }
+    }
+    return nullptr;
+  }
+  bool availableForWriteAll() {
+    return true;
+  }
+
+  AsyncWebSocketMessageBuffer* makeBuffer(size_t size = 0) {
+    return new AsyncWebSocketMessageBuffer(size);
+  }
+
+  void textAll(AsyncWebSocketSharedBuffer buffer) {
+    for (AsyncWebSocketClient& c : _clients) {
+      c.text(buffer);
+    }
+  }
+  void textAll(AsyncWebSocketMessageBuffer* buffer) {
+    if (buffer) {
+      textAll(buffer->_buffer);
+      delete buffer;
+    }
+  }
+  void textAll(const char* message, size_t len) {
+    // the 3.x server shares one copy between all clients
+    textAll(std::make_shared<std::vector<uint8_t>>(message, message + len));
+  }
+  void textAll(const char* message) {
+    textAll(message, strlen(message));
+  }
+  void textAll(const String& message) {
+    textAll(message.c_str(), message.length());
+  }
+  void binaryAll(AsyncWebSocketSharedBuffer buffer) {
+    textAll(buffer);
+  }
+  void binaryAll(AsyncWebSocketMessageBuffer* buffer) {
+    textAll(buffer);
+  }
+  void binaryAll(const uint8_t* message, size_t len) {
+    textAll((const char*)message, len);
+  }
+  void pingAll(const uint8_t* data = nullptr, size_t len = 0) {
+  }
+  void closeAll(uint16_t code = 0, const char* message = nullptr) {
+    for (AsyncWebSocketClient& c : _clients) {
+      c.close(code, message);
+    }
+  }
+  void cleanupClients(uint16_t maxClients = 8) {
+  }
+
+  // bench helpers mirroring what AsyncTCP would deliver
+  AsyncWebSocketClient* connect() {
+    _clients.emplace_back(this, ++_lastId);
+    AsyncWebSocketClient* c = &_clients.back();
+    emit(c, WS_EVT_CONNECT, nullptr, nullptr, 0);
+    return c;
+  }
+  void receive(AsyncWebSocketClient* c, const char* message) {
+    receiveFrame(c, message, strlen(message), 0, strlen(message), true);
+  }
+  void receiveFrame(AsyncWebSocketClient* c,
+                    const char* data,
+                    size_t len,
+                    uint64_t index,
+                    uint64_t total,
+                    bool final,
+                    uint8_t opcode = WS_TEXT) {
+    AwsFrameInfo info = {};
+    info.message_opcode = WS_TEXT;
+    info.opcode = index == 0 ? opcode : WS_CONTINUATION;
+    info.final = final;
+    info.index = index;
+    info.len = total;
+    std::vector<uint8_t> copy(data, data + len);
+    copy.push_back(0);
+    emit(c, WS_EVT_DATA, &info, copy.data(), len);
+  }
+  void pong(AsyncWebSocketClient* c) {
+    emit(c, WS_EVT_PONG, nullptr, nullptr, 0);
+  }
+  void disconnect(AsyncWebSocketClient* c) {
+    c->_status = WS_DISCONNECTED;
+    emit(c, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  }
+
+ private:
+  friend class AsyncWebSocketClient;
+
+  String _url;
+  AwsEventHandler _handler;
+  std::list<AsyncWebSocketClient> _clients;
+  uint32_t _lastId = 0;
+
+  void emit(AsyncWebSocketClient* c, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    if (_handler) {
+      _handler(this, c, type, arg, data, len);
+    }
+  }
+};
+
+inline void AsyncWebSocketClient::close(uint16_t code, const char* message) {
+  if (_status == WS_CONNECTED) {
+    _status = WS_DISCONNECTED;
+    _server->emit(this, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  }
+}
+
+#endif  // end AsyncWebSocket_h
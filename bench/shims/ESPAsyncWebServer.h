@@ -0,0 +1,405 @@
+#ifndef ESPAsyncWebServer_h
+#define ESPAsyncWebServer_h
+
+// Fake AsyncWebServer for the native build. Handlers are registered exactly as on the device; the benchmarks create
+// AsyncWebServerRequest objects directly and dispatch them with AsyncWebServer::handle(). Responses are rendered into
+// memory so that serialization cost and output size are part of every measurement.
+
+#include <Arduino.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebHeader {
+ public:
+  AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {
+  }
+  const String& name() const {
+    return _name;
+  }
+  const String& value() const {
+    return _value;
+  }
+
+ private:
+  String _name;
+  String _value;
+};
+
+class AsyncWebParameter {
+ public:
+  AsyncWebParameter(const String& name, const String& value) : _name(name), _value(value) {
+  }
+  const String& name() const {
+    return _name;
+  }
+  const String& value() const {
+    return _value;
+  }
+
+ private:
+  String _name;
+  String _value;
+};
+
+class AsyncWebServerResponse {
+ public:
+  AsyncWebServerResponse(int code = 200, const String& contentType = String()) :
+      _code(code), _contentType(contentType) {
+  }
+  virtual ~AsyncWebServerResponse() {
+  }
+
+  void addHeader(const String& name, const String& value) {
+    _headers.push_back(AsyncWebHeader(name, value));
+  }
+  void setCode(int code) {
+    _code = code;
+  }
+  void setContentType(const String& type) {
+    _contentType = type;
+  }
+  void setContentLength(size_t len) {
+    _contentLength = len;
+  }
+  int code() const {
+    return _code;
+  }
+  const std::list<AsyncWebHeader>& headers() const {
+    return _headers;
+  }
+
+  // writes the body as the TCP layer would see it
+  virtual void render(String& out) {
+  }
+
+ protected:
+  int _code;
+  String _contentType;
+  size_t _contentLength = 0;
+  std::list<AsyncWebHeader> _headers;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+ public:
+  AsyncBasicResponse(int code, const String& contentType, const String& content) :
+      AsyncWebServerResponse(code, contentType), _content(content) {
+  }
+  void render(String& out) override {
+    out.concat(_content);
+  }
+
+ private:
+  String _content;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse {
+ public:
+  AsyncChunkedResponse(const String& contentType, AwsResponseFiller filler) :
+      AsyncWebServerResponse(200, contentType), _filler(filler) {
+  }
+  void render(String& out) override {
+    // mirrors the ~1.4 KB TCP window the async server offers the filler per call
+    uint8_t buffer[1436];
+    size_t index = 0;
+    size_t len;
+    while ((len = _filler(buffer, sizeof(buffer), index)) > 0) {
+      out.concat((const char*)buffer, len);
+      index += len;
+    }
+  }
+
+ private:
+  AwsResponseFiller _filler;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+ public:
+  AsyncResponseStream(const String& contentType, size_t bufferSize) : AsyncWebServerResponse(200, contentType) {
+  }
+  size_t write(uint8_t c) override {
+    _content.concat((char)c);
+    return 1;
+  }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    _content.concat((const char*)buffer, size);
+    return size;
+  }
+  using Print::write;
+  void render(String& out) override {
+    out.concat(_content);
+  }
+
+ private:
+  String _content;
+};
+
+class AsyncWebServerRequest {
+ public:
+  AsyncWebServerRequest(WebRequestMethod method, const String& url, const String& body = String()) :
+      _method(method), _url(url), _body(body) {
+    int query = url.indexOf('?');
+    if (query >= 0) {
+      _url = url.substring(0, query);
+      String params = url.substring(query + 1);
+      while (params.length()) {
+        int amp = params.indexOf('&');
+        String pair = amp >= 0 ? params.substring(0, amp) : params;
+        params = amp >= 0 ? params.substring(amp + 1) : String();
+        int eq = pair.indexOf('=');
+        _params.push_back(eq >= 0 ? AsyncWebParameter(pair.substring(0, eq), pair.substring(eq + 1))
+                                  : AsyncWebParameter(pair, String()));
+      }
+    }
+  }
+  ~AsyncWebServerRequest() {
+    delete _response;
+  }
+
+  WebRequestMethodComposite method() const {
+    return _method;
+  }
+  const String& url() const {
+    return _url;
+  }
+  const String& body() const {
+    return _body;
+  }
+
+  void addHeader(const String& name, const String& value) {
+    _headers.push_back(AsyncWebHeader(name, value));
+  }
+  bool hasHeader(const String& name) const {
+    return getHeader(name) != nullptr;
+  }
+  const AsyncWebHeader* getHeader(const String& name) const {
+    for (const AsyncWebHeader& header : _headers) {
+      if (header.name().equalsIgnoreCase(name)) {
+        return &header;
+      }
+    }
+    return nullptr;
+  }
+  AsyncWebHeader* getHeader(const String& name) {
+    for (AsyncWebHeader& header : _headers) {
+      if (header.name().equalsIgnoreCase(name)) {
+        return &header;
+      }
+    }
+    return nullptr;
+  }
+  String header(const char* name) const {
+    const AsyncWebHeader* h = getHeader(name);
+    return h ? h->value() : String();
+  }
+  bool hasParam(const String& name) const {
+    return getParam(name) != nullptr;
+  }
+  const AsyncWebParameter* getParam(const String& name) const {
+    for (const AsyncWebParameter& param : _params) {
+      if (param.name() == name) {
+        return &param;
+      }
+    }
+    return nullptr;
+  }
+  AsyncWebParameter* getParam(const String& name) {
+    for (AsyncWebParameter& param : _params) {
+      if (param.name() == name) {
+        return &param;
+      }
+    }
+    return nullptr;
+  }
+  String arg(const String& name) const {
+    const AsyncWebParameter* p = getParam(name);
+    return p ? p->value() : String();
+  }
+
+  void onDisconnect(ArDisconnectHandler fn) {
+    _onDisconnect = fn;
+  }
+
+  AsyncWebServerResponse* beginResponse(int code,
+                                        const String& contentType = String(),
+                                        const String& content = String()) {
+    return new AsyncBasicResponse(code, contentType, content);
+  }
+  AsyncWebServerResponse* beginResponse(int code, const String& contentType, const uint8_t* content, size_t len) {
+    return new AsyncBasicResponse(code, contentType, String((const char*)content, len));
+  }
+  AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller filler) {
+    return new AsyncChunkedResponse(contentType, filler);
+  }
+  AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460) {
+    return new AsyncResponseStream(contentType, bufferSize);
+  }
+
+  void send(AsyncWebServerResponse* response) {
+    delete _response;
+    _response = response;
+    _output = String();
+    _response->render(_output);
+  }
+  void send(int code, const String& contentType = String(), const String& content = String()) {
+    send(beginResponse(code, contentType, content));
+  }
+
+  // simulates the client closing the connection after the response was delivered
+  void finish() {
+    if (_onDisconnect) {
+      ArDisconnectHandler fn = _onDisconnect;
+      _onDisconnect = nullptr;
+      fn();
+    }
+  }
+
+  int responseCode() const {
+    return _response ? _response->code() : 0;
+  }
+  const AsyncWebServerResponse* response() const {
+    return _response;
+  }
+  const String& output() const {
+    return _output;
+  }
+
+ private:
+  WebRequestMethodComposite _method;
+  String _url;
+  String _body;
+  std::list<AsyncWebHeader> _headers;
+  std::list<AsyncWebParameter> _params;
+  ArDisconnectHandler _onDisconnect;
+  AsyncWebServerResponse* _response = nullptr;
+  String _output;
+};
+
+class AsyncWebHandler {
+ public:
+  virtual ~AsyncWebHandler() {
+  }
+  virtual bool canHandle(AsyncWebServerRequest* request) {
+    return false;
+  }
+  virtual void handleRequest(AsyncWebServerRequest* request) {
+  }
+  void setFilter(ArRequestFilterFunction filter) {
+    _filter = filter;
+  }
+  bool filter(AsyncWebServerRequest* request) {
+    return !_filter || _filter(request);
+  }
+
+ private:
+  ArRequestFilterFunction _filter;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+ public:
+  AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) :
+      _uri(uri), _method(method), _onRequest(onRequest) {
+  }
+  bool canHandle(AsyncWebServerRequest* request) override {
+    return (request->method() & _method) && request->url() == _uri;
+  }
+  void handleRequest(AsyncWebServerRequest* request) override {
+    _onRequest(request);
+  }
+
+ private:
+  String _uri;
+  WebRequestMethodComposite _method;
+  ArRequestHandlerFunction _onRequest;
+};
+
+class AsyncWebServer {
+ public:
+  AsyncWebServer(uint16_t port) {
+  }
+  ~AsyncWebServer() {
+    for (AsyncWebHandler* handler : _owned) {
+      delete handler;
+    }
+  }
+
+  void begin() {
+  }
+
+  AsyncWebHandler& addHandler(AsyncWebHandler* handler) {
+    _handlers.push_back(handler);
+    return *handler;
+  }
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+    AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method, onRequest);
+    _owned.push_back(handler);
+    addHandler(handler);
+    return *handler;
+  }
+  void onNotFound(ArRequestHandlerFunction fn) {
+    _notFound = fn;
+  }
+
+  // routes the request to the first matching handler, as the async server does
+  bool handle(AsyncWebServerRequest* request) {
+    for (AsyncWebHandler* handler : _handlers) {
+      if (handler->filter(request) && handler->canHandle(request)) {
+        handler->handleRequest(request);
+        return true;
+      }
+    }
+    if (_notFound) {
+      _notFound(request);
+    } else {
+      request->send(404);
+    }
+    return false;
+  }
+
+  // bench helper: lets the benchmarks reach handlers the framework registered internally (e.g. AsyncWebSocket)
+  const std::vector<AsyncWebHandler*>& handlers() const {
+    return _handlers;
+  }
+
+ private:
+  std::vector<AsyncWebHandler*> _handlers;
+  std::vector<AsyncWebHandler*> _owned;
+  ArRequestHandlerFunction _notFound;
+};
+
+class DefaultHeaders {
+ public:
+  static DefaultHeaders& Instance() {
+    static DefaultHeaders instance;
+    return instance;
+  }
+  void addHeader(const String& name, const String& value) {
+  }
+};
+
+#include <AsyncWebSocket.h>
+
+#endif  // end ESPAsyncWebServer_h
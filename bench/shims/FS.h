@@ -0,0 +1,203 @@
+#ifndef FS_h
+#define FS_h
+
+// In-memory file system with the fs::FS / fs::File interface of the ESP32 core. Files are kept in a map keyed by
+// absolute path; directories are tracked so that mkdir/exists/openNextFile behave like LittleFS for flat layouts.
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+struct FileData {
+  std::vector<uint8_t> bytes;
+};
+
+class FS;
+
+class File : public Stream {
+ public:
+  File() {
+  }
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (!_data || !_writable) {
+      return 0;
+    }
+    _data->bytes.insert(_data->bytes.end(), buffer, buffer + size);
+    _position = _data->bytes.size();
+    return size;
+  }
+  using Print::write;
+
+  int available() override {
+    return _data ? (int)(_data->bytes.size() - _position) : 0;
+  }
+  int read() override {
+    return available() > 0 ? _data->bytes[_position++] : -1;
+  }
+  int peek() override {
+    return available() > 0 ? _data->bytes[_position] : -1;
+  }
+  size_t read(uint8_t* buffer, size_t size) {
+    size_t n = std::min(size, (size_t)available());
+    if (n) {
+      memcpy(buffer, _data->bytes.data() + _position, n);
+      _position += n;
+    }
+    return n;
+  }
+  bool seek(uint32_t pos) {
+    if (!_data || pos > _data->bytes.size()) {
+      return false;
+    }
+    _position = pos;
+    return true;
+  }
+  size_t position() const {
+    return _position;
+  }
+  size_t size() const {
+    return _data ? _data->bytes.size() : 0;
+  }
+  void close() {
+    _data.reset();
+    _entries.clear();
+  }
+  const char* path() const {
+    return _path.c_str();
+  }
+  const char* name() const {
+    size_t slash = _path.rfind('/');
+    return slash == std::string::npos ? _path.c_str() : _path.c_str() + slash + 1;
+  }
+  bool isDirectory() const {
+    return _directory;
+  }
+  File openNextFile(const char* mode = "r");
+
+  explicit operator bool() const {
+    return _data != nullptr || _directory;
+  }
+
+ private:
+  friend class FS;
+
+  FS* _fs = nullptr;
+  std::shared_ptr<FileData> _data;
+  std::string _path;
+  size_t _position = 0;
+  bool _writable = false;
+  bool _directory = false;
+  std::vector<std::string> _entries;
+};
+
+class FS {
+ public:
+  File open(const char* path, const char* mode = "r") {
+    File file;
+    file._fs = this;
+    file._path = path;
+    if (_directories.count(path)) {
+      file._directory = true;
+      std::string prefix = std::string(path) + "/";
+      for (auto& entry : _files) {
+        if (entry.first.compare(0, prefix.length(), prefix) == 0 &&
+            entry.first.find('/', prefix.length()) == std::string::npos) {
+          file._entries.push_back(entry.first);
+        }
+      }
+      return file;
+    }
+    auto it = _files.find(path);
+    if (mode[0] == 'w' || (mode[0] == 'a' && it == _files.end())) {
+      auto data = std::make_shared<FileData>();
+      _files[path] = data;
+      file._data = data;
+      file._writable = true;
+    } else if (it != _files.end()) {
+      file._data = it->second;
+      file._writable = mode[0] == 'a';
+      file._position = file._writable ? it->second->bytes.size() : 0;
+    }
+    writes += file._writable ? 1 : 0;
+    return file;
+  }
+  File open(const String& path, const char* mode = "r") {
+    return open(path.c_str(), mode);
+  }
+
+  bool exists(const char* path) {
+    return _files.count(path) || _directories.count(path);
+  }
+  bool exists(const String& path) {
+    return exists(path.c_str());
+  }
+  bool mkdir(const char* path) {
+    _directories.insert(path);
+    return true;
+  }
+  bool mkdir(const String& path) {
+    return mkdir(path.c_str());
+  }
+  bool remove(const char* path) {
+    return _files.erase(path) > 0;
+  }
+  bool remove(const String& path) {
+    return remove(path.c_str());
+  }
+  bool rename(const char* from, const char* to) {
+    auto it = _files.find(from);
+    if (it == _files.end()) {
+      return false;
+    }
+    _files[to] = it->second;
+    _files.erase(from);
+    return true;
+  }
+  bool rename(const String& from, const String& to) {
+    return rename(from.c_str(), to.c_str());
+  }
+  size_t totalBytes() {
+    return 1024 * 1024;
+  }
+  size_t usedBytes() {
+    size_t used = 0;
+    for (auto& entry : _files) {
+      used += entry.second->bytes.size();
+    }
+    return used;
+  }
+
+  // number of files opened for writing, used by the benchmarks to verify write avoidance
+  size_t writes = 0;
+
+ private:
+  friend class File;
+  std::map<std::string, std::shared_ptr<FileData>> _files;
+  std::set<std::string> _directories;
+};
+
+inline File File::openNextFile(const char* mode) {
+  if (!_directory || _entries.empty()) {
+    return File();
+  }
+  std::string next = _entries.front();
+  _entries.erase(_entries.begin());
+  return _fs->open(next.c_str(), mode);
+}
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif  // end FS_h
@@ -0,0 +1,17 @@
+#ifndef LittleFS_h
+#define LittleFS_h
+
+#include <FS.h>
+
+namespace fs {
+class LittleFSFS : public FS {
+ public:
+  bool begin(bool formatOnFail = false) {
+    return true;
+  }
+};
+}  // namespace fs
+
+extern fs::LittleFSFS LittleFS;
+
+#endif  // end LittleFS_h
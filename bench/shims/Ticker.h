@@ -0,0 +1,46 @@
+#ifndef Ticker_h
+#define Ticker_h
+
+#include <Arduino.h>
+
+// Timers never fire on the host; the benchmarks drive periodic work explicitly so results stay deterministic.
+class Ticker {
+ public:
+  typedef std::function<void(void)> callback_function_t;
+
+  void attach(float seconds, callback_function_t callback) {
+    _active = true;
+  }
+  void attach_ms(uint32_t milliseconds, callback_function_t callback) {
+    _active = true;
+  }
+  template <typename TArg>
+  void attach(float seconds, void (*callback)(TArg), TArg arg) {
+    _active = true;
+  }
+  template <typename TArg>
+  void attach_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) {
+    _active = true;
+  }
+  void once(float seconds, callback_function_t callback) {
+    _active = true;
+  }
+  void once_ms(uint32_t milliseconds, callback_function_t callback) {
+    _active = true;
+  }
+  template <typename TArg>
+  void once_ms(uint32_t milliseconds, void (*callback)(TArg), TArg arg) {
+    _active = true;
+  }
+  void detach() {
+    _active = false;
+  }
+  bool active() const {
+    return _active;
+  }
+
+ private:
+  bool _active = false;
+};
+
+#endif  // end Ticker_h
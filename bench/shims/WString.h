@@ -0,0 +1,305 @@
+#ifndef WString_h
+#define WString_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+// Host-side stand-in for the Arduino String class, backed by std::string. Only the subset of the API used by
+// lib/framework is provided; formatting of numbers follows the Arduino core (two decimals for floating point).
+
+class __FlashStringHelper;
+class StringSumHelper;
+
+class String {
+ public:
+  String() {
+  }
+  String(const char* cstr) : _str(cstr ? cstr : "") {
+  }
+  String(const char* cstr, size_t length) : _str(cstr ? cstr : "", cstr ? length : 0) {
+  }
+  String(const __FlashStringHelper* str) : _str(str ? reinterpret_cast<const char*>(str) : "") {
+  }
+  explicit String(const std::string& str) : _str(str) {
+  }
+  explicit String(char c) : _str(1, c) {
+  }
+  explicit String(unsigned char value, unsigned char base = 10) : _str(formatUnsigned(value, base)) {
+  }
+  explicit String(int value, unsigned char base = 10) : _str(formatSigned(value, base)) {
+  }
+  explicit String(unsigned int value, unsigned char base = 10) : _str(formatUnsigned(value, base)) {
+  }
+  explicit String(long value, unsigned char base = 10) : _str(formatSigned(value, base)) {
+  }
+  explicit String(unsigned long value, unsigned char base = 10) : _str(formatUnsigned(value, base)) {
+  }
+  explicit String(long long value, unsigned char base = 10) : _str(formatSigned(value, base)) {
+  }
+  explicit String(unsigned long long value, unsigned char base = 10) : _str(formatUnsigned(value, base)) {
+  }
+  explicit String(float value, unsigned char decimals = 2) : _str(formatFloat(value, decimals)) {
+  }
+  explicit String(double value, unsigned char decimals = 2) : _str(formatFloat(value, decimals)) {
+  }
+
+  String& operator=(const char* cstr) {
+    _str = cstr ? cstr : "";
+    return *this;
+  }
+
+  const char* c_str() const {
+    return _str.c_str();
+  }
+  size_t length() const {
+    return _str.length();
+  }
+  bool isEmpty() const {
+    return _str.empty();
+  }
+  bool reserve(size_t size) {
+    _str.reserve(size);
+    return true;
+  }
+  char* begin() {
+    return &_str[0];
+  }
+  char* end() {
+    return &_str[0] + _str.length();
+  }
+  char operator[](size_t index) const {
+    return index < _str.length() ? _str[index] : 0;
+  }
+  char& operator[](size_t index) {
+    return _str[index];
+  }
+  char charAt(size_t index) const {
+    return (*this)[index];
+  }
+
+  bool concat(const String& str) {
+    _str += str._str;
+    return true;
+  }
+  bool concat(const char* cstr) {
+    if (cstr) {
+      _str += cstr;
+    }
+    return true;
+  }
+  bool concat(const char* cstr, size_t length) {
+    if (cstr) {
+      _str.append(cstr, length);
+    }
+    return true;
+  }
+  bool concat(char c) {
+    _str += c;
+    return true;
+  }
+  template <typename V>
+  bool concat(V value) {
+    return concat(String(value));
+  }
+
+  template <typename V>
+  String& operator+=(const V& value) {
+    concat(value);
+    return *this;
+  }
+
+  bool equals(const String& other) const {
+    return _str == other._str;
+  }
+  bool equals(const char* cstr) const {
+    return _str == (cstr ? cstr : "");
+  }
+  bool equalsIgnoreCase(const String& other) const {
+    return strcasecmp(c_str(), other.c_str()) == 0;
+  }
+  bool startsWith(const String& prefix) const {
+    return _str.compare(0, prefix._str.length(), prefix._str) == 0;
+  }
+  bool endsWith(const String& suffix) const {
+    return _str.length() >= suffix._str.length() &&
+           _str.compare(_str.length() - suffix._str.length(), suffix._str.length(), suffix._str) == 0;
+  }
+  int compareTo(const String& other) const {
+    return _str.compare(other._str);
+  }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = _str.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String& str, unsigned int from = 0) const {
+    size_t pos = _str.find(str._str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int lastIndexOf(char c) const {
+    size_t pos = _str.rfind(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  String substring(unsigned int left) const {
+    return left >= _str.length() ? String() : String(_str.substr(left));
+  }
+  String substring(unsigned int left, unsigned int right) const {
+    if (left > right) {
+      unsigned int tmp = left;
+      left = right;
+      right = tmp;
+    }
+    if (left >= _str.length()) {
+      return String();
+    }
+    return String(_str.substr(left, right - left));
+  }
+
+  void replace(const String& find, const String& replace) {
+    if (find._str.empty()) {
+      return;
+    }
+    size_t pos = 0;
+    while ((pos = _str.find(find._str, pos)) != std::string::npos) {
+      _str.replace(pos, find._str.length(), replace._str);
+      pos += replace._str.length();
+    }
+  }
+  void remove(unsigned int index) {
+    if (index < _str.length()) {
+      _str.erase(index);
+    }
+  }
+  void remove(unsigned int index, unsigned int count) {
+    if (index < _str.length()) {
+      _str.erase(index, count);
+    }
+  }
+  void trim() {
+    size_t first = _str.find_first_not_of(" \t\r\n");
+    size_t last = _str.find_last_not_of(" \t\r\n");
+    _str = first == std::string::npos ? std::string() : _str.substr(first, last - first + 1);
+  }
+  void toLowerCase() {
+    for (char& c : _str) {
+      if (c >= 'A' && c <= 'Z') {
+        c = c - 'A' + 'a';
+      }
+    }
+  }
+  void toUpperCase() {
+    for (char& c : _str) {
+      if (c >= 'a' && c <= 'z') {
+        c = c - 'a' + 'A';
+      }
+    }
+  }
+
+  long toInt() const {
+    return strtol(c_str(), nullptr, 10);
+  }
+  float toFloat() const {
+    return strtof(c_str(), nullptr);
+  }
+  double toDouble() const {
+    return strtod(c_str(), nullptr);
+  }
+
+  explicit operator bool() const {
+    return true;
+  }
+
+  friend bool operator==(const String& a, const String& b) {
+    return a._str == b._str;
+  }
+  friend bool operator==(const String& a, const char* b) {
+    return a.equals(b);
+  }
+  friend bool operator==(const char* a, const String& b) {
+    return b.equals(a);
+  }
+  friend bool operator!=(const String& a, const String& b) {
+    return !(a == b);
+  }
+  friend bool operator!=(const String& a, const char* b) {
+    return !(a == b);
+  }
+  friend bool operator!=(const char* a, const String& b) {
+    return !(b == a);
+  }
+  friend bool operator<(const String& a, const String& b) {
+    return a._str < b._str;
+  }
+
+ private:
+  std::string _str;
+
+  template <typename V>
+  static std::string formatUnsigned(V value, unsigned char base) {
+    char buf[8 * sizeof(V) + 1];
+    char* p = buf + sizeof(buf) - 1;
+    *p = 0;
+    if (base < 2) {
+      base = 10;
+    }
+    do {
+      unsigned digit = (unsigned)(value % base);
+      *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+      value /= base;
+    } while (value);
+    return std::string(p);
+  }
+
+  template <typename V>
+  static std::string formatSigned(V value, unsigned char base) {
+    if (value < 0 && base == 10) {
+      return "-" + formatUnsigned((unsigned long long)(-(long long)value), base);
+    }
+    return formatUnsigned((unsigned long long)value, base);
+  }
+
+  static std::string formatFloat(double value, unsigned char decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    return std::string(buf);
+  }
+};
+
+// Present so ArduinoJson's Arduino string adapters resolve as they do on the device.
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& s) : String(s) {
+  }
+};
+
+inline StringSumHelper operator+(const String& lhs, const String& rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+inline StringSumHelper operator+(const String& lhs, const char* rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+inline StringSumHelper operator+(const char* lhs, const String& rhs) {
+  StringSumHelper result = String(lhs);
+  result.concat(rhs);
+  return result;
+}
+inline StringSumHelper operator+(const String& lhs, char rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+template <typename V>
+inline StringSumHelper operator+(const String& lhs, V rhs) {
+  StringSumHelper result(lhs);
+  result.concat(String(rhs));
+  return result;
+}
+
+#endif  // end WString_h
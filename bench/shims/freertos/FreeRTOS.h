@@ -0,0 +1,46 @@
+#ifndef FreeRTOS_h
+#define FreeRTOS_h
+
+// Host implementation of the FreeRTOS primitives used by lib/framework. Ticks are milliseconds, queues, mutexes and
+// tasks are backed by the C++ standard library so that lock and hand-off costs are measured on real threads.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define configASSERT(x) \
+  do {                  \
+    if (!(x)) {         \
+      abort();          \
+    }                   \
+  } while (0)
+
+namespace freertos_shim {
+
+inline std::chrono::steady_clock::time_point deadline(TickType_t ticks) {
+  return ticks == portMAX_DELAY ? std::chrono::steady_clock::time_point::max()
+                                : std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+}
+
+}  // namespace freertos_shim
+
+#endif  // end FreeRTOS_h
@@ -0,0 +1,40 @@
+#ifndef semphr_h
+#define semphr_h
+
+#include <freertos/FreeRTOS.h>
+
+struct SemaphoreShim {
+  std::recursive_timed_mutex mutex;
+};
+
+typedef SemaphoreShim* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+  return new SemaphoreShim();
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new SemaphoreShim();
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  delete semaphore;
+}
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    semaphore->mutex.lock();
+    return pdTRUE;
+  }
+  return semaphore->mutex.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) {
+  semaphore->mutex.unlock();
+  return pdTRUE;
+}
+
+#define xSemaphoreTake xSemaphoreTakeRecursive
+#define xSemaphoreGive xSemaphoreGiveRecursive
+
+#endif  // end semphr_h
@@ -0,0 +1,84 @@
+#ifndef task_h
+#define task_h
+
+#include <freertos/FreeRTOS.h>
+
+typedef void (*TaskFunction_t)(void*);
+
+struct TaskShim {
+  std::thread thread;
+  uint32_t notifications = 0;
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+typedef TaskShim* TaskHandle_t;
+
+namespace freertos_shim {
+inline TaskShim*& currentTask() {
+  static thread_local TaskShim* task = nullptr;
+  return task;
+}
+}  // namespace freertos_shim
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn,
+                                          const char* name,
+                                          uint32_t stackDepth,
+                                          void* parameters,
+                                          UBaseType_t priority,
+                                          TaskHandle_t* handle,
+                                          BaseType_t coreId) {
+  TaskShim* task = new TaskShim();
+  if (handle) {
+    *handle = task;
+  }
+  task->thread = std::thread([task, fn, parameters]() {
+    freertos_shim::currentTask() = task;
+    fn(parameters);
+  });
+  task->thread.detach();
+  return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t fn,
+                              const char* name,
+                              uint32_t stackDepth,
+                              void* parameters,
+                              UBaseType_t priority,
+                              TaskHandle_t* handle) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, parameters, priority, handle, tskNO_AFFINITY);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return freertos_shim::currentTask();
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline void vTaskDelete(TaskHandle_t) {
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->notifications++;
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticks) {
+  TaskShim* task = freertos_shim::currentTask();
+  if (!task) {
+    return 0;
+  }
+  std::unique_lock<std::mutex> lock(task->mutex);
+  task->cv.wait_until(lock, freertos_shim::deadline(ticks), [task] { return task->notifications > 0; });
+  uint32_t value = task->notifications;
+  if (value) {
+    task->notifications = clearCountOnExit ? 0 : value - 1;
+  }
+  return value;
+}
+
+#endif  // end task_h
@@ -0,0 +1,2 @@
+// Declarations only; ArduinoJsonJWT.cpp is not part of the native build.
+#include <stddef.h>
@@ -0,0 +1,28 @@
+// src/components/dynamic-component/utils/formSchema.ts
+import { Form } from '../types';
+
+/**
+ * Збирає форми з окремо отриманих схеми (поля з "o", значення null) і плоских значень key → value,
+ * у тому ж вигляді, що й повна відповідь REST
+ */
+export const mergeFormValues = (
+  schema: Record<string, Form>,
+  values: Record<string, any>
+): Record<string, Form> => {
+  const forms: Record<string, Form> = {};
+  Object.entries(schema).forEach(([name, form]) => {
+    forms[name] = {
+      ...form,
+      fields: form.fields.map((field) => {
+        const merged: Record<string, any> = { ...field };
+        Object.keys(field).forEach((key) => {
+          if (key !== 'o' && key in values) {
+            merged[key] = values[key];
+          }
+        });
+        return merged as typeof field;
+      }),
+    };
+  });
+  return forms;
+};
@@ -1,4 +1,4 @@
-import { FC, useEffect, useState } from 'react';
+import { FC, useCallback, useEffect, useState } from 'react';
 import { Navigate, Route, Routes } from 'react-router-dom';
 import { Tab } from '@mui/material';
 import { RouterTabs, useRouterTab, useLayoutTitle } from '../../components';
@@ -12,8 +12,10 @@ import FormLoader from '../../components/loading/FormLoader';
 const TelegramService: FC = () => {
   useLayoutTitle("Telegram Control");
   const { routerTab } = useRouterTab();
+  // кожна вкладка запитує лише свою форму
+  const readForm = useCallback(() => readState(routerTab || undefined), [routerTab]);
   const { loadData, saveData, saving, setData, data, errorMessage } = useRest<any>({
-    read: readState,
+    read: readForm,
     update: updateState,
   });
 
@@ -52,7 +54,9 @@ const TelegramService: FC = () => {
       });
   };
 
-  if (!data) {
+  // після зміни вкладки data ще містить попередню форму, доки loadData не завантажить нову
+  const formMissing = (routerTab === 'status' || routerTab === 'settings') && !data?.[routerTab];
+  if (!data || formMissing) {
     return <FormLoader errorMessage={errorMessage} message="Loading REST data..." />;
   }
 
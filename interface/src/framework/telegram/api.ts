@@ -5,8 +5,9 @@ import { AXIOS, WEB_SOCKET_ROOT } from "../../api/endpoints";
 
 export const WEBSOCKET_URL = WEB_SOCKET_ROOT + "telegramStatus";
 
-export function readState(): AxiosPromise<Record<string, any>> {
-  return AXIOS.get('/telegramForm');
+// form — лише одна форма ("status" | "settings"), без неї сервер віддає всі
+export function readState(form?: string): AxiosPromise<Record<string, any>> {
+  return AXIOS.get('/telegramForm', { params: form ? { form } : undefined });
 }
 
 export function updateState(data: Record<string, any>): AxiosPromise<Record<string, any>> {
@@ -18,7 +18,12 @@ const LightControl: FC = () => {
   });
 
   // Отримуємо wsData через useWs
-  const { connected, wsData, updateData: updateWsData, disconnect } = useWs<any>(LIGHT_SETTINGS_WEBSOCKET_URL);
+  const { connected, wsData, updateData: updateWsData, subscribe, disconnect } = useWs<any>(LIGHT_SETTINGS_WEBSOCKET_URL);
+
+  // Живі дані потрібні лише вкладці Status
+  useEffect(() => {
+    subscribe(routerTab === 'status' ? { forms: ['status'] } : { keys: [] });
+  }, [routerTab, subscribe]);
 
   // Зберігаємо origin_id у локальному стані
   const [originId, setOriginId] = useState<string>("");
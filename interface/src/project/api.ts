@@ -2,11 +2,23 @@ import { AxiosPromise } from "axios";
 
 import { AXIOS, WEB_SOCKET_ROOT } from "../api/endpoints";
 import { LightMqttSettings, LightState } from "./types";
+import { Form } from "../components/dynamic-component/types";
+import { mergeFormValues } from "../components/dynamic-component/utils/formSchema";
 
 export const LIGHT_SETTINGS_WEBSOCKET_URL = WEB_SOCKET_ROOT + "lightState";
 
-export function readState(): AxiosPromise<Record<string, any>> {
-  return AXIOS.get('/lightState');
+export function readSchema(): AxiosPromise<Record<string, Form>> {
+  return AXIOS.get('/lightStateSchema');
+}
+
+export function readValues(): AxiosPromise<Record<string, any>> {
+  return AXIOS.get('/lightStateValues');
+}
+
+// Схема кешується браузером (ETag), щоразу приходять лише значення
+export async function readState(): AxiosPromise<Record<string, any>> {
+  const [schema, values] = await Promise.all([readSchema(), readValues()]);
+  return { ...values, data: mergeFormValues(schema.data, values.data) };
 }
 
 export function updateState(data: Record<string, any>): AxiosPromise<Record<string, any>> {
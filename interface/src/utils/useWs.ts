@@ -17,10 +17,60 @@ export interface WebSocketIdMessage {
 export interface WebSocketPayloadMessage<D> {
   type: 'p';
   origin_id: string;
+  rev?: number;
   p: D;
 }
 
-export type WebSocketMessage<D> = WebSocketIdMessage | WebSocketPayloadMessage<D>;
+// Лише змінені ключі (JSON merge patch): null — ключ видалено, вкладені об'єкти зливаються
+export interface WebSocketDeltaMessage<D> {
+  type: 'd';
+  origin_id: string;
+  rev?: number;
+  d: Partial<D>;
+}
+
+// Відповідь автору зміни замість луни його ж значень: стан rev уже містить надіслане
+export interface WebSocketAckMessage {
+  type: 'ack';
+  origin_id: string;
+  rev: number;
+}
+
+export type WebSocketMessage<D> =
+  | WebSocketIdMessage
+  | WebSocketPayloadMessage<D>
+  | WebSocketDeltaMessage<D>
+  | WebSocketAckMessage;
+
+/**
+ * Підписка на частину ключів: forms розгортаються сервером у ключі форм,
+ * keys: [] — нічого не надсилати, undefined — усі ключі
+ */
+export interface WebSocketSubscription {
+  forms?: string[];
+  keys?: string[];
+}
+
+const isPlainObject = (value: unknown): value is Record<string, unknown> =>
+  typeof value === 'object' && value !== null && !Array.isArray(value);
+
+/**
+ * Накладає merge patch (RFC 7396) на копію target
+ */
+export const mergePatch = <T>(target: T, patch: unknown): T => {
+  if (!isPlainObject(patch)) {
+    return patch as T;
+  }
+  const result: Record<string, unknown> = isPlainObject(target) ? { ...target } : {};
+  Object.entries(patch).forEach(([key, value]) => {
+    if (value === null) {
+      delete result[key];
+    } else {
+      result[key] = mergePatch(result[key], value);
+    }
+  });
+  return result as T;
+};
 
 /**
  * Хук useWs: створює та підтримує WebSocket-з'єднання
@@ -35,6 +85,9 @@ export const useWs = <D>(
 ) => {
   const ws = useRef<Sockette>();
   const clientId = useRef<string>();
+  // Остання підписка — повторюється після перепідключення
+  const subscription = useRef<WebSocketSubscription>();
+  const open = useRef<boolean>(false);
 
   // Стан з'єднання
   const [connected, setConnected] = useState<boolean>(false);
@@ -42,6 +95,8 @@ export const useWs = <D>(
   const [originId, setOriginId] = useState<string>('');
   // Основні дані, прийняті через WebSocket (якщо "p" - payload)
   const [wsData, setWsData] = useState<D | undefined>();
+  // Ревізія стану на сервері, якій відповідає wsData
+  const [revision, setRevision] = useState<number>();
 
   // Контроль передачі (чи зберегти дані на сервер), а також чи чистити локальні дані
   const [transmit, setTransmit] = useState<boolean>(false);
@@ -68,6 +123,25 @@ export const useWs = <D>(
             }
             // Записуємо в локальний стан payload
             setWsData(message.p);
+            setRevision(message.rev);
+            break;
+          case 'd':
+            if (message.origin_id) {
+              setOriginId(message.origin_id);
+            }
+            // Без повного стану патчу нема до чого застосувати — просимо сервер надіслати його
+            setWsData((prev) => {
+              if (prev === undefined) {
+                ws.current?.json({ type: 'resync' });
+                return prev;
+              }
+              return mergePatch(prev, message.d);
+            });
+            setRevision(message.rev);
+            break;
+          case 'ack':
+            // Наші значення прийняті як є — локальний wsData вже актуальний
+            setRevision(message.rev);
             break;
           default:
             console.warn(`[useWs] Unknown message type: ${message}`);
@@ -112,6 +186,23 @@ export const useWs = <D>(
     setClear(clearData);
   };
 
+  /**
+   * Підписка лише на потрібні ключі/форми (сервер відповідає повним станом у їх межах)
+   */
+  const subscribe = useCallback((sub?: WebSocketSubscription) => {
+    subscription.current = sub;
+    if (open.current) {
+      ws.current?.json({ type: 'sub', ...sub });
+    }
+  }, []);
+
+  /**
+   * Запит повного стану (після пропущених патчів)
+   */
+  const resync = useCallback(() => {
+    ws.current?.json({ type: 'resync' });
+  }, []);
+
   /**
    * Відключення WebSocket
    */
@@ -142,11 +233,16 @@ export const useWs = <D>(
     const instance = new Sockette(addAccessTokenParameter(wsUrl), {
       onmessage: onMessage,
       onopen: () => {
+        open.current = true;
         setConnected(true);
         attempts = 0;
+        if (subscription.current) {
+          instance.json({ type: 'sub', ...subscription.current });
+        }
         console.log('[useWs] WebSocket connected');
       },
       onclose: () => {
+        open.current = false;
         clientId.current = undefined;
         setConnected(false);
         setWsData(undefined); // очищуємо локальний wsData
@@ -177,7 +273,10 @@ export const useWs = <D>(
     connected,
     originId,
     wsData,
+    revision,
     updateData,
+    resync,
+    subscribe,
     disconnect,
   } as const;
 };
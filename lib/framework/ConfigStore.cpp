@@ -0,0 +1,327 @@
+#include <ConfigStore.h>
+
+ConfigStore* ConfigStore::_defaultStore = nullptr;
+
+ConfigStore::ConfigStore(FS* fs, const char* logPath) :
+    _fs(fs),
+    _logPath(logPath),
+    _logSize(0),
+    _liveSize(0)
+#ifdef ESP32
+    ,
+    _mutex(xSemaphoreCreateRecursiveMutex())
+#endif
+{
+}
+
+bool ConfigStore::begin() {
+  lock();
+  _index.clear();
+  _logSize = 0;
+  _liveSize = 0;
+
+  int slash = _logPath.lastIndexOf('/');
+  if (slash > 0) {
+    String directory = _logPath.substring(0, slash);
+    if (!_fs->exists(directory)) {
+      _fs->mkdir(directory);
+    }
+  }
+
+  // a compaction is only committed by the rename, its temp file is complete once the log has been removed
+  String tempPath = _logPath + CONFIG_STORE_TEMP_SUFFIX;
+  if (_fs->exists(tempPath)) {
+    if (_fs->exists(_logPath)) {
+      _fs->remove(tempPath);
+    } else {
+      _fs->rename(tempPath, _logPath);
+    }
+  }
+
+  bool intact = true;
+  File log = _fs->open(_logPath, "r");
+  if (log) {
+    size_t size = log.size();
+    size_t offset = 0;
+    uint8_t header[CONFIG_STORE_HEADER_SIZE];
+    char key[CONFIG_STORE_MAX_KEY_SIZE + 1];
+    uint8_t buffer[64];
+    while (offset < size) {
+      if (log.read(header, sizeof(header)) != sizeof(header) || header[0] != CONFIG_STORE_RECORD_MAGIC ||
+          (header[1] != RECORD_PUT && header[1] != RECORD_DELETE)) {
+        intact = false;
+        break;
+      }
+      size_t keyLength = header[2];
+      size_t length = header[3] | (header[4] << 8);
+      if (offset + recordSize(keyLength, length) > size || log.read((uint8_t*)key, keyLength) != keyLength) {
+        intact = false;
+        break;
+      }
+      key[keyLength] = 0;
+
+      uint32_t recordCrc = crc32Update(0, (const uint8_t*)key, keyLength);
+      uint32_t valueCrc = 0;
+      size_t remaining = length;
+      while (remaining) {
+        size_t chunk = log.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+        if (!chunk) {
+          break;
+        }
+        recordCrc = crc32Update(recordCrc, buffer, chunk);
+        valueCrc = crc32Update(valueCrc, buffer, chunk);
+        remaining -= chunk;
+      }
+      uint8_t trailer[4];
+      if (remaining || log.read(trailer, sizeof(trailer)) != sizeof(trailer) || fsGetUint32(trailer) != recordCrc) {
+        intact = false;
+        break;
+      }
+
+      // the newest record of a key wins
+      if (header[1] == RECORD_PUT) {
+        _index[key] = {(uint32_t)(offset + CONFIG_STORE_HEADER_SIZE + keyLength), (uint16_t)length, valueCrc};
+      } else {
+        _index.erase(key);
+      }
+      offset += recordSize(keyLength, length);
+    }
+    log.close();
+    _logSize = offset;
+  }
+  for (auto& item : _index) {
+    _liveSize += recordSize(item.first.length(), item.second.length);
+  }
+
+  // appending behind a damaged record would hide everything appended later from the next scan
+  if (!intact) {
+    compact();
+  }
+  unlock();
+  return intact;
+}
+
+bool ConfigStore::put(const String& key, size_t length, uint32_t crc, ValueWriter writer) {
+  if (key.length() > CONFIG_STORE_MAX_KEY_SIZE || length > CONFIG_STORE_MAX_VALUE_SIZE) {
+    return false;
+  }
+  lock();
+  bool written = false;
+  Entry entry;
+  File log = _fs->open(_logPath, "a");
+  if (log) {
+    written = append(log, _logSize, RECORD_PUT, key, length, crc, writer, &entry);
+    log.close();
+    if (written) {
+      auto existing = _index.find(key);
+      if (existing != _index.end()) {
+        _liveSize -= recordSize(key.length(), existing->second.length);
+      }
+      _index[key] = entry;
+      _liveSize += recordSize(key.length(), length);
+      _logSize += recordSize(key.length(), length);
+      maybeCompact();
+    } else {
+      // drop the partial record before anything is appended behind it
+      compact();
+    }
+  }
+  unlock();
+  return written;
+}
+
+bool ConfigStore::get(const String& key, ValueReader reader) {
+  bool result = false;
+  lock();
+  auto entry = _index.find(key);
+  if (entry != _index.end()) {
+    File log = _fs->open(_logPath, "r");
+    if (log && log.seek(entry->second.valueOffset)) {
+      ConfigStoreValueStream value(log, entry->second.length);
+      result = reader(value);
+    }
+    log.close();
+  }
+  unlock();
+  return result;
+}
+
+bool ConfigStore::lookup(const String& key, uint32_t* crc, size_t* length) {
+  lock();
+  auto entry = _index.find(key);
+  bool found = entry != _index.end();
+  if (found && crc) {
+    *crc = entry->second.crc;
+  }
+  if (found && length) {
+    *length = entry->second.length;
+  }
+  unlock();
+  return found;
+}
+
+bool ConfigStore::remove(const String& key) {
+  lock();
+  bool removed = true;
+  auto entry = _index.find(key);
+  if (entry != _index.end()) {
+    Entry deleted;
+    File log = _fs->open(_logPath, "a");
+    removed = log && append(log, _logSize, RECORD_DELETE, key, 0, 0, nullptr, &deleted);
+    log.close();
+    if (removed) {
+      _liveSize -= recordSize(key.length(), entry->second.length);
+      _logSize += recordSize(key.length(), 0);
+      _index.erase(entry);
+      maybeCompact();
+    } else {
+      compact();
+    }
+  }
+  unlock();
+  return removed;
+}
+
+void ConfigStore::clear() {
+  lock();
+  _fs->remove(_logPath);
+  _fs->remove(_logPath + CONFIG_STORE_TEMP_SUFFIX);
+  _index.clear();
+  _logSize = 0;
+  _liveSize = 0;
+  unlock();
+}
+
+bool ConfigStore::compact() {
+  lock();
+  String tempPath = _logPath + CONFIG_STORE_TEMP_SUFFIX;
+  File source = _fs->open(_logPath, "r");
+  File target = _fs->open(tempPath, "w");
+  bool written = (bool)target;
+  std::map<String, Entry> index;
+  size_t offset = 0;
+  for (auto& item : _index) {
+    if (!written) {
+      break;
+    }
+    const Entry& current = item.second;
+    Entry entry;
+    written = source && source.seek(current.valueOffset) &&
+              append(
+                  target,
+                  offset,
+                  RECORD_PUT,
+                  item.first,
+                  current.length,
+                  current.crc,
+                  [&source, &current](Print& value) {
+                    uint8_t buffer[64];
+                    size_t remaining = current.length;
+                    while (remaining) {
+                      size_t chunk = source.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+                      if (!chunk) {
+                        break;
+                      }
+                      value.write(buffer, chunk);
+                      remaining -= chunk;
+                    }
+                  },
+                  &entry);
+    index[item.first] = entry;
+    offset += recordSize(item.first.length(), current.length);
+  }
+  target.close();
+  source.close();
+
+  // same swap as an atomic FSPersistence write, begin() finishes it after a crash between remove and rename
+  if (written && !_fs->rename(tempPath, _logPath)) {
+    _fs->remove(_logPath);
+    written = _fs->rename(tempPath, _logPath);
+  }
+  if (written) {
+    _index.swap(index);
+    _logSize = offset;
+    _liveSize = offset;
+  } else {
+    _fs->remove(tempPath);
+  }
+  unlock();
+  return written;
+}
+
+size_t ConfigStore::logSize() {
+  lock();
+  size_t size = _logSize;
+  unlock();
+  return size;
+}
+
+size_t ConfigStore::liveSize() {
+  lock();
+  size_t size = _liveSize;
+  unlock();
+  return size;
+}
+
+size_t ConfigStore::keys() {
+  lock();
+  size_t count = _index.size();
+  unlock();
+  return count;
+}
+
+bool ConfigStore::append(File& log,
+                         size_t offset,
+                         RecordType type,
+                         const String& key,
+                         size_t length,
+                         uint32_t crc,
+                         ValueWriter writer,
+                         Entry* entry) {
+  uint8_t header[CONFIG_STORE_HEADER_SIZE] = {
+      CONFIG_STORE_RECORD_MAGIC, type, (uint8_t)key.length(), (uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+  if (log.write(header, sizeof(header)) != sizeof(header)) {
+    return false;
+  }
+  FSChecksumPrint record(&log);
+  record.write((const uint8_t*)key.c_str(), key.length());
+  FSChecksumPrint value(&record);
+  if (writer) {
+    writer(value);
+  }
+  // the header promised length bytes, anything else would desync the scan
+  if (record.failed() || value.failed() || value.length() != length || value.crc() != crc) {
+    return false;
+  }
+  uint8_t trailer[4];
+  fsPutUint32(trailer, record.crc());
+  if (log.write(trailer, sizeof(trailer)) != sizeof(trailer)) {
+    return false;
+  }
+  entry->valueOffset = offset + CONFIG_STORE_HEADER_SIZE + key.length();
+  entry->length = length;
+  entry->crc = crc;
+  return true;
+}
+
+void ConfigStore::maybeCompact() {
+  if (_logSize >= CONFIG_STORE_COMPACT_MIN_BYTES && _logSize > CONFIG_STORE_COMPACT_RATIO * _liveSize) {
+    compact();
+  }
+}
+
+#ifdef ESP32
+void ConfigStore::lock() {
+  xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+}
+
+void ConfigStore::unlock() {
+  xSemaphoreGiveRecursive(_mutex);
+}
+#else
+void ConfigStore::lock() {
+}
+
+void ConfigStore::unlock() {
+}
+#endif
@@ -0,0 +1,159 @@
+#ifndef ConfigStore_h
+#define ConfigStore_h
+
+#include <Arduino.h>
+#include <FS.h>
+#include <FSPersistenceChecksum.h>
+
+#include <functional>
+#include <map>
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
+// Set to 1 to keep the FSPersistence configs in a single ConfigStore log instead of one file per service
+#ifndef FS_PERSISTENCE_CONFIG_STORE
+#define FS_PERSISTENCE_CONFIG_STORE 0
+#endif
+
+#ifndef CONFIG_STORE_LOG_PATH
+#define CONFIG_STORE_LOG_PATH "/config/store.log"
+#endif
+
+// The log is compacted once it is larger than CONFIG_STORE_COMPACT_RATIO times the live records and at least
+// CONFIG_STORE_COMPACT_MIN_BYTES, so a few settings changes never trigger a rewrite.
+#ifndef CONFIG_STORE_COMPACT_RATIO
+#define CONFIG_STORE_COMPACT_RATIO 2
+#endif
+
+#ifndef CONFIG_STORE_COMPACT_MIN_BYTES
+#define CONFIG_STORE_COMPACT_MIN_BYTES 4096
+#endif
+
+#define CONFIG_STORE_TEMP_SUFFIX ".tmp"
+#define CONFIG_STORE_RECORD_MAGIC 0xC5
+#define CONFIG_STORE_HEADER_SIZE 5
+#define CONFIG_STORE_MAX_VALUE_SIZE 0xFFFF
+#define CONFIG_STORE_MAX_KEY_SIZE 0xFF
+
+/**
+ * Append-only key/value store kept in a single LittleFS file.
+ *
+ * Every put() or remove() appends one record: magic, type, key length (u8), value length (u16 LE), the key, the value
+ * and the CRC-32 of key and value (u32 LE). begin() reads the log once from start to end and indexes the newest record
+ * of every key; a torn or damaged tail ends the scan and is dropped by compacting the log. Compaction copies the live
+ * records to a temp file which is then renamed over the log.
+ */
+class ConfigStore {
+ public:
+  typedef std::function<void(Print& value)> ValueWriter;
+  typedef std::function<bool(Stream& value)> ValueReader;
+
+  ConfigStore(FS* fs, const char* logPath = CONFIG_STORE_LOG_PATH);
+
+  // indexes the log, returns false if it had to drop a damaged tail
+  bool begin();
+
+  // appends a record, length and crc of the value must be known up front (e.g. from a measuring pass)
+  bool put(const String& key, size_t length, uint32_t crc, ValueWriter writer);
+
+  // streams the newest value of the key to the reader
+  bool get(const String& key, ValueReader reader);
+
+  bool lookup(const String& key, uint32_t* crc = nullptr, size_t* length = nullptr);
+
+  bool contains(const String& key) {
+    return lookup(key);
+  }
+
+  bool remove(const String& key);
+
+  // drops every record, used by the factory reset
+  void clear();
+
+  bool compact();
+
+  size_t logSize();
+  size_t liveSize();
+  size_t keys();
+
+  // the store used by FSPersistence, none unless installed
+  static ConfigStore* defaultStore() {
+    return _defaultStore;
+  }
+  static void setDefault(ConfigStore* store) {
+    _defaultStore = store;
+  }
+
+ private:
+  enum RecordType : uint8_t { RECORD_PUT = 1, RECORD_DELETE = 2 };
+
+  struct Entry {
+    uint32_t valueOffset;
+    uint16_t length;
+    uint32_t crc;  // of the value alone, comparable to what FSPersistence measures
+  };
+
+  FS* _fs;
+  String _logPath;
+  std::map<String, Entry> _index;
+  size_t _logSize;
+  size_t _liveSize;
+
+  static ConfigStore* _defaultStore;
+
+  bool append(File& log,
+              size_t offset,
+              RecordType type,
+              const String& key,
+              size_t length,
+              uint32_t crc,
+              ValueWriter writer,
+              Entry* entry);
+  static size_t recordSize(size_t keyLength, size_t length) {
+    return CONFIG_STORE_HEADER_SIZE + keyLength + length + 4;
+  }
+  void maybeCompact();
+
+  void lock();
+  void unlock();
+
+#ifdef ESP32
+  SemaphoreHandle_t _mutex;
+#endif
+};
+
+/**
+ * Stream over one value inside the log, ends after the value's last byte.
+ */
+class ConfigStoreValueStream : public Stream {
+ public:
+  ConfigStoreValueStream(File& log, size_t length) : _log(log), _remaining(length) {
+    // the end of the value is final, readBytes() must not wait for more
+    setTimeout(0);
+  }
+
+  int available() override {
+    return (int)_remaining;
+  }
+  int read() override {
+    if (!_remaining) {
+      return -1;
+    }
+    _remaining--;
+    return _log.read();
+  }
+  int peek() override {
+    return _remaining ? _log.peek() : -1;
+  }
+  size_t write(uint8_t c) override {
+    return 0;
+  }
+
+ private:
+  File& _log;
+  size_t _remaining;
+};
+
+#endif  // end ConfigStore_h
@@ -2,7 +2,11 @@
 // Якщо треба: #include "LightStateService.h"
 
 ESP8266React::ESP8266React(AsyncWebServer* server)
-  : _featureService(server),
+  :
+#if FS_PERSISTENCE_CONFIG_STORE
+    _configStore(&ESPFS),
+#endif
+    _featureService(server),
     _securitySettingsService(server, &ESPFS),
     _wifiSettingsService(server, &ESPFS, &_securitySettingsService),
     _wifiScanner(server, &_securitySettingsService),
@@ -32,7 +36,9 @@ ESP8266React::ESP8266React(AsyncWebServer* server)
 #endif
     _restartService(server, &_securitySettingsService),
     _factoryResetService(server, &ESPFS, &_securitySettingsService),
-    _systemStatus(server, &_securitySettingsService)
+    _systemStatus(server, &_securitySettingsService),
+    _jsonCapacityStatus(server, &_securitySettingsService),
+    _wsClientsStatus(server, &_securitySettingsService, &_wsManager)
 {
   #ifdef PROGMEM_WWW
   WWWData::registerRoutes(
@@ -84,6 +90,11 @@ void ESP8266React::begin() {
   ESPFS.begin(true);
 #elif defined(ESP8266)
   ESPFS.begin();
+#endif
+#if FS_PERSISTENCE_CONFIG_STORE
+  // one scan of the log indexes every config before the services read theirs
+  _configStore.begin();
+  ConfigStore::setDefault(&_configStore);
 #endif
   _wifiSettingsService.begin();
   _apSettingsService.begin();
@@ -102,13 +113,16 @@ void ESP8266React::begin() {
 #if FT_ENABLED(FT_TELEGRAM)
   _telegramService.begin();
 #endif
+  // WebSocket events, queues and state broadcasts are handled by their own task from here on
+  _wsManager.beginDispatchTask();
 }
 
 void ESP8266React::loop() {
   _wifiSettingsService.loop();
   _apSettingsService.loop();
-  // _wsManager.processRxQueueInLoop();
+  // only wakes the WebSocket dispatch task, kept as a fallback if it could not be started
   _wsManager.processAllQueues();
+  FSPersistenceWorker::loop();
 #if FT_ENABLED(FT_OTA)
   _otaSettingsService.loop();
 #endif
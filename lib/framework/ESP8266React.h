@@ -25,12 +25,15 @@
 #include <RestartService.h>
 #include <SecuritySettingsService.h>
 #include <SystemStatus.h>
+#include <JsonCapacityStatus.h>
 #include <WiFiScanner.h>
 #include <WiFiSettingsService.h>
 #include <WiFiStatus.h>
+#include <WsClientsStatus.h>
 #include <TelegramService.h>
 
 #include <ESPFS.h>
+#include <ConfigStore.h>
 
 #include <NewMultiWsService.h>
 
@@ -110,6 +113,9 @@ void factoryReset() {
   }
 
  private:
+#if FS_PERSISTENCE_CONFIG_STORE
+  ConfigStore _configStore;
+#endif
  FeaturesService _featureService;
  SecuritySettingsService _securitySettingsService;
  WiFiSettingsService _wifiSettingsService;
@@ -141,6 +147,8 @@ void factoryReset() {
   RestartService _restartService;
   FactoryResetService _factoryResetService;
   SystemStatus _systemStatus;
+  JsonCapacityStatus _jsonCapacityStatus;
+  WsClientsStatus _wsClientsStatus;
 };
 
 #endif  // ESP8266React_h
@@ -2,10 +2,51 @@
 #define FSPersistence_h
 
 #include <StatefulService.h>
+#include <FSPersistenceWorker.h>
+#include <FSPersistenceChecksum.h>
+#include <ConfigStore.h>
+#include <JsonCapacity.h>
 #include <FS.h>
 
+// Atomic writes: serialize into FS_PERSISTENCE_TEMP_SUFFIX next to the file, append a CRC trailer and rename it over
+// the original, so a power loss leaves either the old or the new file, never a truncated one.
+#ifndef FS_PERSISTENCE_ATOMIC_WRITES
+#define FS_PERSISTENCE_ATOMIC_WRITES 1
+#endif
+
+#define FS_PERSISTENCE_TEMP_SUFFIX ".tmp"
+
+// On-flash encoding. MSGPACK files are stored next to the JSON path with FS_PERSISTENCE_MSGPACK_EXTENSION; an existing
+// JSON file is migrated on the first boot after switching.
+enum class FSPersistenceFormat { JSON, MSGPACK };
+
+#ifndef FS_PERSISTENCE_DEFAULT_FORMAT
+#define FS_PERSISTENCE_DEFAULT_FORMAT FSPersistenceFormat::JSON
+#endif
+
+#define FS_PERSISTENCE_MSGPACK_EXTENSION ".msgpack"
+
+inline size_t fsSerialize(JsonDocument& jsonDocument, Print& output, FSPersistenceFormat format) {
+  return format == FSPersistenceFormat::MSGPACK ? serializeMsgPack(jsonDocument, output)
+                                                : serializeJson(jsonDocument, output);
+}
+
+inline DeserializationError fsDeserialize(JsonDocument& jsonDocument, Stream& input, FSPersistenceFormat format) {
+  return format == FSPersistenceFormat::MSGPACK ? deserializeMsgPack(jsonDocument, input)
+                                                : deserializeJson(jsonDocument, input);
+}
+
+// Default write-behind timing of every FSPersistence, a quiet period of 0 writes synchronously in the update handler
+#ifndef FS_WRITE_BEHIND_QUIET_MS
+#define FS_WRITE_BEHIND_QUIET_MS 500
+#endif
+
+#ifndef FS_WRITE_BEHIND_MAX_LATENCY_MS
+#define FS_WRITE_BEHIND_MAX_LATENCY_MS 3000
+#endif
+
 template <class T>
-class FSPersistence {
+class FSPersistence : public FSPersistenceWriter {
  public:
   FSPersistence(JsonStateReader<T> stateReader,
                 JsonStateUpdater<T> stateUpdater,
@@ -18,24 +59,49 @@ class FSPersistence {
       _statefulService(statefulService),
       _fs(fs),
       _filePath(filePath),
-      _bufferSize(bufferSize),
+      _capacity(filePath, bufferSize),
+      _persistedFields(STATE_CHANGE_ALL),
+      _quietPeriodMs(FS_WRITE_BEHIND_QUIET_MS),
+      _maxLatencyMs(FS_WRITE_BEHIND_MAX_LATENCY_MS),
+      _hasPersistedCrc(false),
+      _persistedCrc(0),
+      _writesPerformed(0),
+      _writesSkipped(0),
       _updateHandlerId(0) {
+    setFormat(FS_PERSISTENCE_DEFAULT_FORMAT);
     enableUpdateHandler();
   }
 
+  ~FSPersistence() {
+    disableUpdateHandler();
+    FSPersistenceWorker::cancel(this);
+  }
+
   void readFromFS() {
-    File settingsFile = _fs->open(_filePath, "r");
+    // with a ConfigStore installed the config is a record keyed by the file path
+    ConfigStore* store = ConfigStore::defaultStore();
+    if (store ? readRecord(store, currentPath(), _format) : readFile(currentPath(), _format)) {
+      return;
+    }
 
-    if (settingsFile) {
-      DynamicJsonDocument jsonDocument = DynamicJsonDocument(_bufferSize);
-      DeserializationError error = deserializeJson(jsonDocument, settingsFile);
-      if (error == DeserializationError::Ok && jsonDocument.is<JsonObject>()) {
-        JsonObject jsonObject = jsonDocument.as<JsonObject>();
-        _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
-        settingsFile.close();
-        return;
+    // first boot after switching to MessagePack or to the store: load the older copy, write it anew and drop it
+    if (store && _format == FSPersistenceFormat::MSGPACK && readRecord(store, _filePath, FSPersistenceFormat::JSON)) {
+      if (rewriteToFS()) {
+        store->remove(_filePath);
       }
-      settingsFile.close();
+      return;
+    }
+    if (store && readFile(currentPath(), _format)) {
+      if (rewriteToFS()) {
+        _fs->remove(currentPath());
+      }
+      return;
+    }
+    if (_format == FSPersistenceFormat::MSGPACK && readFile(_filePath, FSPersistenceFormat::JSON)) {
+      if (rewriteToFS()) {
+        _fs->remove(_filePath);
+      }
+      return;
     }
 
     // If we reach here we have not been successful in loading the config and hard-coded defaults are now applied.
@@ -45,17 +111,62 @@ class FSPersistence {
     writeToFS();
   }
 
-  bool writeToFS() {
+  bool writeToFS() override {
     // create and populate a new json object
-    DynamicJsonDocument jsonDocument = DynamicJsonDocument(_bufferSize);
-    JsonObject jsonObject = jsonDocument.to<JsonObject>();
-    _statefulService->read(jsonObject, _stateReader);
+    DynamicJsonDocument jsonDocument = _capacity.fill([&](JsonDocument& document) {
+      JsonObject jsonObject = document.to<JsonObject>();
+      _statefulService->read(jsonObject, _stateReader);
+    });
+
+    const char* filePath = currentPath();
+    ConfigStore* store = ConfigStore::defaultStore();
+
+    // skip the write when the serialized bytes equal what was last persisted
+    FSChecksumPrint content;
+    fsSerialize(jsonDocument, content, _format);
+    if (_hasPersistedCrc && content.crc() == _persistedCrc &&
+        (store ? store->contains(filePath) : _fs->exists(filePath))) {
+      _writesSkipped++;
+      return true;
+    }
+
+    // a store write appends a single record, the length and CRC are known from the measuring pass
+    if (store) {
+      _hasPersistedCrc = store->put(filePath, content.length(), content.crc(), [&](Print& value) {
+        fsSerialize(jsonDocument, value, _format);
+      });
+      _persistedCrc = content.crc();
+      _writesPerformed++;
+      return _hasPersistedCrc;
+    }
 
     // make directories if required
     mkdirs();
 
+#if FS_PERSISTENCE_ATOMIC_WRITES
+    String tempPath = String(filePath) + FS_PERSISTENCE_TEMP_SUFFIX;
+    File settingsFile = _fs->open(tempPath, "w");
+    if (!settingsFile) {
+      return false;
+    }
+
+    // serialize the data followed by the CRC trailer, then swap the complete file in
+    FSChecksumPrint checksum(&settingsFile);
+    fsSerialize(jsonDocument, checksum, _format);
+    bool written = !checksum.failed() && fsWriteTrailer(settingsFile, checksum.crc());
+    settingsFile.close();
+    if (!written) {
+      _fs->remove(tempPath);
+      _hasPersistedCrc = false;
+      return false;
+    }
+    _hasPersistedCrc = commitTempFile(tempPath, filePath);
+    _persistedCrc = content.crc();
+    _writesPerformed++;
+    return _hasPersistedCrc;
+#else
     // serialize it to filesystem
-    File settingsFile = _fs->open(_filePath, "w");
+    File settingsFile = _fs->open(filePath, "w");
 
     // failed to open file, return false
     if (!settingsFile) {
@@ -63,9 +174,29 @@ class FSPersistence {
     }
 
     // serialize the data to the file
-    serializeJson(jsonDocument, settingsFile);
+    FSChecksumPrint checksum(&settingsFile);
+    fsSerialize(jsonDocument, checksum, _format);
     settingsFile.close();
+    _hasPersistedCrc = !checksum.failed();
+    _persistedCrc = content.crc();
+    _writesPerformed++;
     return true;
+#endif
+  }
+
+  // Selects the on-flash encoding, call before readFromFS()
+  void setFormat(FSPersistenceFormat format) {
+    _format = format;
+    _hasPersistedCrc = false;
+    if (_format == FSPersistenceFormat::MSGPACK) {
+      _binaryPath = _filePath;
+      if (_binaryPath.endsWith(".json")) {
+        _binaryPath.remove(_binaryPath.length() - 5);
+      }
+      _binaryPath += FS_PERSISTENCE_MSGPACK_EXTENSION;
+    } else {
+      _binaryPath = String();
+    }
   }
 
   void disableUpdateHandler() {
@@ -77,19 +208,164 @@ class FSPersistence {
 
   void enableUpdateHandler() {
     if (!_updateHandlerId) {
-      _updateHandlerId = _statefulService->addUpdateHandler([&](const String& originId) { writeToFS(); });
+      _updateHandlerId = _statefulService->addChangeHandler([&](const String& originId, state_change_mask_t changed) {
+        if (!(changed & _persistedFields)) {
+          return;
+        }
+        if (_quietPeriodMs) {
+          FSPersistenceWorker::schedule(this, _quietPeriodMs, _maxLatencyMs);
+        } else {
+          writeToFS();
+        }
+      });
+    }
+  }
+
+  // Changes are written by the persistence worker once none arrived for quietPeriodMs, at the latest maxLatencyMs
+  // after the first unsaved one. A quiet period of 0 writes synchronously from the update handler.
+  void setWriteBehind(uint32_t quietPeriodMs, uint32_t maxLatencyMs = FS_WRITE_BEHIND_MAX_LATENCY_MS) {
+    _quietPeriodMs = quietPeriodMs;
+    _maxLatencyMs = maxLatencyMs;
+    if (!_quietPeriodMs) {
+      flush();
     }
   }
 
+  // writes a pending write-behind change now, returns true if there was one
+  bool flush() {
+    return FSPersistenceWorker::flush(this);
+  }
+
+  // file writes done vs. skipped because the content was already on flash
+  uint32_t writesPerformed() const {
+    return _writesPerformed;
+  }
+
+  uint32_t writesSkipped() const {
+    return _writesSkipped;
+  }
+
+  // Changes that touch none of these fields (e.g. runtime-only status) do not rewrite the file
+  void setPersistedFields(state_change_mask_t fields) {
+    _persistedFields = fields;
+  }
+
  private:
   JsonStateReader<T> _stateReader;
   JsonStateUpdater<T> _stateUpdater;
   StatefulService<T>* _statefulService;
   FS* _fs;
   const char* _filePath;
-  size_t _bufferSize;
+  JsonCapacity _capacity;
+  state_change_mask_t _persistedFields;
+  uint32_t _quietPeriodMs;
+  uint32_t _maxLatencyMs;
+  bool _hasPersistedCrc;
+  uint32_t _persistedCrc;
+  uint32_t _writesPerformed;
+  uint32_t _writesSkipped;
+  FSPersistenceFormat _format;
+  String _binaryPath;
   update_handler_id_t _updateHandlerId;
 
+  const char* currentPath() const {
+    return _format == FSPersistenceFormat::MSGPACK ? _binaryPath.c_str() : _filePath;
+  }
+
+  bool readFile(const char* filePath, FSPersistenceFormat format) {
+#if FS_PERSISTENCE_ATOMIC_WRITES
+    recoverTempFile(filePath);
+#endif
+    File settingsFile = _fs->open(filePath, "r");
+    bool loaded = false;
+
+    if (settingsFile) {
+      // a file with a bad CRC trailer is rejected without parsing it
+      uint32_t payloadCrc;
+      FSPayloadCheck check = fsCheckPayload(settingsFile, nullptr, &payloadCrc);
+      if (check != FSPayloadCheck::CORRUPT) {
+        DeserializationError error;
+        DynamicJsonDocument jsonDocument = _capacity.parse(
+            [&](JsonDocument& document) {
+              settingsFile.seek(0);
+              return fsDeserialize(document, settingsFile, format);
+            },
+            &error);
+        if (error == DeserializationError::Ok && jsonDocument.is<JsonObject>()) {
+          JsonObject jsonObject = jsonDocument.as<JsonObject>();
+          _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
+          // the trailer already tells us what is on flash
+          _hasPersistedCrc = check == FSPayloadCheck::VALID;
+          _persistedCrc = payloadCrc;
+          loaded = true;
+        }
+      }
+      settingsFile.close();
+    }
+    return loaded;
+  }
+
+  bool readRecord(ConfigStore* store, const char* key, FSPersistenceFormat format) {
+    uint32_t crc;
+    if (!store->lookup(key, &crc)) {
+      return false;
+    }
+    DeserializationError error;
+    DynamicJsonDocument jsonDocument = _capacity.parse(
+        [&](JsonDocument& document) {
+          DeserializationError result = DeserializationError::EmptyInput;
+          store->get(key, [&](Stream& value) {
+            result = fsDeserialize(document, value, format);
+            return true;
+          });
+          return result;
+        },
+        &error);
+    if (error != DeserializationError::Ok || !jsonDocument.is<JsonObject>()) {
+      return false;
+    }
+    JsonObject jsonObject = jsonDocument.as<JsonObject>();
+    _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
+    // the store verified the record when it indexed the log
+    _hasPersistedCrc = true;
+    _persistedCrc = crc;
+    return true;
+  }
+
+  // writes state loaded from an older location, which never matches what the new location holds
+  bool rewriteToFS() {
+    _hasPersistedCrc = false;
+    return writeToFS();
+  }
+
+#if FS_PERSISTENCE_ATOMIC_WRITES
+  bool commitTempFile(const String& tempPath, const char* filePath) {
+    if (_fs->rename(tempPath, filePath)) {
+      return true;
+    }
+    // some LittleFS ports refuse to rename over an existing file; the temp file survives a crash in between and is
+    // picked up by recoverTempFile()
+    _fs->remove(filePath);
+    return _fs->rename(tempPath, filePath);
+  }
+
+  // A temp file left by a crash is promoted when complete (it is newer than the file) and dropped otherwise.
+  void recoverTempFile(const char* filePath) {
+    String tempPath = String(filePath) + FS_PERSISTENCE_TEMP_SUFFIX;
+    if (!_fs->exists(tempPath)) {
+      return;
+    }
+    File tempFile = _fs->open(tempPath, "r");
+    bool complete = tempFile && fsCheckPayload(tempFile) == FSPayloadCheck::VALID;
+    tempFile.close();
+    if (complete) {
+      commitTempFile(tempPath, filePath);
+    } else {
+      _fs->remove(tempPath);
+    }
+  }
+#endif
+
   // We assume we have a _filePath with format "/directory1/directory2/filename"
   // We create a directory for each missing parent
   void mkdirs() {
@@ -107,7 +383,7 @@ class FSPersistence {
   // We assume the updater supplies sensible defaults if an empty object
   // is supplied, this virtual function allows that to be changed.
   virtual void applyDefaults() {
-    DynamicJsonDocument jsonDocument = DynamicJsonDocument(_bufferSize);
+    DynamicJsonDocument jsonDocument = DynamicJsonDocument(JSON_CAPACITY_MIN_SIZE);
     JsonObject jsonObject = jsonDocument.as<JsonObject>();
     _statefulService->updateWithoutPropagation(jsonObject, _stateUpdater);
   }
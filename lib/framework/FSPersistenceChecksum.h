@@ -0,0 +1,131 @@
+#ifndef FSPersistenceChecksum_h
+#define FSPersistenceChecksum_h
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Files written atomically end with an 8 byte trailer: FS_PERSISTENCE_TRAILER_MAGIC followed by the CRC-32 of the
+// payload, both little endian. Files without the trailer are accepted as written by older firmware.
+#define FS_PERSISTENCE_TRAILER_MAGIC 0x31435346UL  // "FSC1"
+#define FS_PERSISTENCE_TRAILER_SIZE 8
+
+enum class FSPayloadCheck {
+  VALID,   // trailer present and CRC matches
+  LEGACY,  // no trailer
+  CORRUPT  // trailer present, CRC does not match (torn or damaged file)
+};
+
+// CRC-32 (IEEE 802.3), nibble table to keep the flash footprint small. Start with 0, feed the previous result back in.
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+  static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                     0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                     0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+    crc = (crc >> 4) ^ table[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+/**
+ * Print adapter computing the CRC-32 and length of everything written through it. With a null target it only
+ * measures, which lets a payload be hashed without touching the file system.
+ */
+class FSChecksumPrint : public Print {
+ public:
+  explicit FSChecksumPrint(Print* target = nullptr) : _target(target), _crc(0), _length(0), _failed(false) {
+  }
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    size_t written = _target ? _target->write(buffer, size) : size;
+    if (written != size) {
+      _failed = true;
+    }
+    _crc = crc32Update(_crc, buffer, written);
+    _length += written;
+    return written;
+  }
+
+  uint32_t crc() const {
+    return _crc;
+  }
+  size_t length() const {
+    return _length;
+  }
+  bool failed() const {
+    return _failed;
+  }
+
+ private:
+  Print* _target;
+  uint32_t _crc;
+  size_t _length;
+  bool _failed;
+};
+
+inline void fsPutUint32(uint8_t* out, uint32_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  out[2] = (value >> 16) & 0xFF;
+  out[3] = (value >> 24) & 0xFF;
+}
+
+inline uint32_t fsGetUint32(const uint8_t* in) {
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+inline bool fsWriteTrailer(File& file, uint32_t crc) {
+  uint8_t trailer[FS_PERSISTENCE_TRAILER_SIZE];
+  fsPutUint32(trailer, FS_PERSISTENCE_TRAILER_MAGIC);
+  fsPutUint32(trailer + 4, crc);
+  return file.write(trailer, sizeof(trailer)) == sizeof(trailer);
+}
+
+/**
+ * Validates the trailer of an open file and rewinds it. payloadSize receives the number of bytes before the trailer
+ * (the whole file for LEGACY), crc the CRC of a VALID payload. A CORRUPT file is rejected without parsing it.
+ */
+inline FSPayloadCheck fsCheckPayload(File& file, size_t* payloadSize = nullptr, uint32_t* payloadCrc = nullptr) {
+  size_t size = file.size();
+  if (payloadSize) {
+    *payloadSize = size;
+  }
+  if (size < FS_PERSISTENCE_TRAILER_SIZE) {
+    return FSPayloadCheck::LEGACY;
+  }
+  uint8_t trailer[FS_PERSISTENCE_TRAILER_SIZE];
+  size_t payload = size - FS_PERSISTENCE_TRAILER_SIZE;
+  if (!file.seek(payload) || file.read(trailer, sizeof(trailer)) != sizeof(trailer) ||
+      fsGetUint32(trailer) != FS_PERSISTENCE_TRAILER_MAGIC) {
+    file.seek(0);
+    return FSPayloadCheck::LEGACY;
+  }
+  file.seek(0);
+  uint8_t buffer[64];
+  uint32_t crc = 0;
+  size_t remaining = payload;
+  while (remaining) {
+    size_t chunk = file.read(buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+    if (!chunk) {
+      break;
+    }
+    crc = crc32Update(crc, buffer, chunk);
+    remaining -= chunk;
+  }
+  file.seek(0);
+  if (payloadSize) {
+    *payloadSize = payload;
+  }
+  if (payloadCrc) {
+    *payloadCrc = crc;
+  }
+  return remaining == 0 && crc == fsGetUint32(trailer + 4) ? FSPayloadCheck::VALID : FSPayloadCheck::CORRUPT;
+}
+
+#endif  // end FSPersistenceChecksum_h
@@ -0,0 +1,190 @@
+#include <FSPersistenceWorker.h>
+
+std::list<FSPersistenceWorker::PendingWrite> FSPersistenceWorker::_pending;
+
+#ifdef ESP32
+TaskHandle_t FSPersistenceWorker::_task = nullptr;
+
+static SemaphoreHandle_t pendingMutex() {
+  static SemaphoreHandle_t mutex = xSemaphoreCreateRecursiveMutex();
+  return mutex;
+}
+
+static SemaphoreHandle_t writeMutex() {
+  static SemaphoreHandle_t mutex = xSemaphoreCreateRecursiveMutex();
+  return mutex;
+}
+#endif
+
+void FSPersistenceWorker::schedule(FSPersistenceWriter* writer, uint32_t quietPeriodMs, uint32_t maxLatencyMs) {
+  unsigned long now = millis();
+  lockPending();
+  PendingWrite* entry = nullptr;
+  for (PendingWrite& pendingWrite : _pending) {
+    if (pendingWrite.writer == writer) {
+      entry = &pendingWrite;
+      break;
+    }
+  }
+  if (!entry) {
+    _pending.push_back({writer, now, now});
+    entry = &_pending.back();
+  }
+  // push the deadline out by the quiet period, bounded by the latency limit of the first unsaved change
+  unsigned long sinceFirstChange = now - entry->firstChangeMs;
+  uint32_t delayMs = quietPeriodMs;
+  if (sinceFirstChange >= maxLatencyMs) {
+    delayMs = 0;
+  } else if (sinceFirstChange + delayMs > maxLatencyMs) {
+    delayMs = maxLatencyMs - sinceFirstChange;
+  }
+  entry->dueMs = now + delayMs;
+#ifdef ESP32
+  if (!_task) {
+    xTaskCreate(task, "FSPersistence", FS_PERSISTENCE_TASK_STACK_SIZE, nullptr, FS_PERSISTENCE_TASK_PRIORITY, &_task);
+  }
+  TaskHandle_t worker = _task;
+#endif
+  unlockPending();
+#ifdef ESP32
+  if (worker) {
+    xTaskNotifyGive(worker);
+  }
+#endif
+}
+
+bool FSPersistenceWorker::flush(FSPersistenceWriter* writer) {
+  bool found = false;
+  lockPending();
+  for (auto i = _pending.begin(); i != _pending.end(); ++i) {
+    if (i->writer == writer) {
+      _pending.erase(i);
+      found = true;
+      break;
+    }
+  }
+  unlockPending();
+  if (found) {
+    write(writer);
+  }
+  return found;
+}
+
+void FSPersistenceWorker::cancel(FSPersistenceWriter* writer) {
+  lockPending();
+  for (auto i = _pending.begin(); i != _pending.end(); ++i) {
+    if (i->writer == writer) {
+      _pending.erase(i);
+      break;
+    }
+  }
+  unlockPending();
+  lockWrite();
+  unlockWrite();
+}
+
+void FSPersistenceWorker::flushAll() {
+  FSPersistenceWriter* writer;
+  while ((writer = takeDue(true, nullptr)) != nullptr) {
+    write(writer);
+  }
+  // a write the worker task took before the drain may still be running
+  lockWrite();
+  unlockWrite();
+}
+
+void FSPersistenceWorker::discardAll() {
+  lockPending();
+  _pending.clear();
+  unlockPending();
+  lockWrite();
+  unlockWrite();
+}
+
+void FSPersistenceWorker::loop() {
+#ifndef ESP32
+  writeDue();
+#endif
+}
+
+size_t FSPersistenceWorker::pending() {
+  lockPending();
+  size_t count = _pending.size();
+  unlockPending();
+  return count;
+}
+
+FSPersistenceWriter* FSPersistenceWorker::takeDue(bool all, uint32_t* nextDueInMs) {
+  unsigned long now = millis();
+  FSPersistenceWriter* writer = nullptr;
+  uint32_t nextDue = UINT32_MAX;
+  lockPending();
+  for (auto i = _pending.begin(); i != _pending.end(); ++i) {
+    long remaining = (long)(i->dueMs - now);
+    if (all || remaining <= 0) {
+      writer = i->writer;
+      _pending.erase(i);
+      break;
+    }
+    if ((uint32_t)remaining < nextDue) {
+      nextDue = remaining;
+    }
+  }
+  unlockPending();
+  if (nextDueInMs) {
+    *nextDueInMs = nextDue;
+  }
+  return writer;
+}
+
+void FSPersistenceWorker::write(FSPersistenceWriter* writer) {
+  lockWrite();
+  writer->writeToFS();
+  unlockWrite();
+}
+
+uint32_t FSPersistenceWorker::writeDue() {
+  uint32_t nextDueInMs;
+  FSPersistenceWriter* writer;
+  while ((writer = takeDue(false, &nextDueInMs)) != nullptr) {
+    write(writer);
+  }
+  return nextDueInMs;
+}
+
+#ifdef ESP32
+void FSPersistenceWorker::task(void* parameters) {
+  for (;;) {
+    uint32_t nextDueInMs = writeDue();
+    ulTaskNotifyTake(pdTRUE, nextDueInMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(nextDueInMs) + 1);
+  }
+}
+
+void FSPersistenceWorker::lockPending() {
+  xSemaphoreTakeRecursive(pendingMutex(), portMAX_DELAY);
+}
+
+void FSPersistenceWorker::unlockPending() {
+  xSemaphoreGiveRecursive(pendingMutex());
+}
+
+void FSPersistenceWorker::lockWrite() {
+  xSemaphoreTakeRecursive(writeMutex(), portMAX_DELAY);
+}
+
+void FSPersistenceWorker::unlockWrite() {
+  xSemaphoreGiveRecursive(writeMutex());
+}
+#else
+void FSPersistenceWorker::lockPending() {
+}
+
+void FSPersistenceWorker::unlockPending() {
+}
+
+void FSPersistenceWorker::lockWrite() {
+}
+
+void FSPersistenceWorker::unlockWrite() {
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef FSPersistenceWorker_h
+#define FSPersistenceWorker_h
+
+#include <Arduino.h>
+
+#include <list>
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
+#ifndef FS_PERSISTENCE_TASK_PRIORITY
+#define FS_PERSISTENCE_TASK_PRIORITY 1
+#endif
+
+#ifndef FS_PERSISTENCE_TASK_STACK_SIZE
+#define FS_PERSISTENCE_TASK_STACK_SIZE 4096
+#endif
+
+/**
+ * Anything the persistence worker can write, implemented by FSPersistence<T>.
+ */
+class FSPersistenceWriter {
+ public:
+  virtual ~FSPersistenceWriter() {
+  }
+  virtual bool writeToFS() = 0;
+};
+
+/**
+ * Write-behind queue shared by all FSPersistence instances.
+ *
+ * A scheduled writer is written once no further change arrived for its quiet period, but never later than its max
+ * latency after the first unsaved change, so a burst of updates (e.g. a dragged slider) costs a single flash write.
+ * On ESP32 the writes happen on a dedicated low priority task, elsewhere loop() must be called regularly.
+ */
+class FSPersistenceWorker {
+ public:
+  static void schedule(FSPersistenceWriter* writer, uint32_t quietPeriodMs, uint32_t maxLatencyMs);
+
+  // writes the writer now if it has a pending write, returns true if it did
+  static bool flush(FSPersistenceWriter* writer);
+
+  // drops the pending write of the writer and waits for one in progress
+  static void cancel(FSPersistenceWriter* writer);
+
+  // writes everything pending and waits for a write in progress, used before a restart
+  static void flushAll();
+
+  // drops everything pending, used before a factory reset removes the files
+  static void discardAll();
+
+  static void loop();
+
+  static size_t pending();
+
+ private:
+  struct PendingWrite {
+    FSPersistenceWriter* writer;
+    unsigned long firstChangeMs;
+    unsigned long dueMs;
+  };
+
+  static std::list<PendingWrite> _pending;
+
+  static FSPersistenceWriter* takeDue(bool all, uint32_t* nextDueInMs);
+  static void write(FSPersistenceWriter* writer);
+  static uint32_t writeDue();
+
+  static void lockPending();
+  static void unlockPending();
+  static void lockWrite();
+  static void unlockWrite();
+
+#ifdef ESP32
+  static TaskHandle_t _task;
+  static void task(void* parameters);
+#endif
+};
+
+#endif  // end FSPersistenceWorker_h
@@ -18,6 +18,13 @@ void FactoryResetService::handleRequest(AsyncWebServerRequest* request) {
  * Delete function assumes that all files are stored flat, within the config directory.
  */
 void FactoryResetService::factoryReset() {
+  // pending write-behind writes would recreate the files deleted below
+  FSPersistenceWorker::discardAll();
+  // the store log holds every migrated config, truncating it resets them all; the walk below removes the rest
+  ConfigStore* store = ConfigStore::defaultStore();
+  if (store) {
+    store->clear();
+  }
 #ifdef ESP32
   File root = fs->open(FS_CONFIG_DIRECTORY);
   File file;
@@ -12,6 +12,7 @@
 #include <ESPAsyncWebServer.h>
 #include <SecurityManager.h>
 #include <RestartService.h>
+#include <ConfigStore.h>
 #include <FS.h>
 
 #define FS_CONFIG_DIRECTORY "/config"
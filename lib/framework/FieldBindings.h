@@ -0,0 +1,296 @@
+#ifndef FieldBindings_h
+#define FieldBindings_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <FormBuilder.h>
+#include <StatefulService.h>
+
+// Parts of the state a binding takes part in, see FieldTable
+enum FieldScope : uint8_t {
+  BIND_FORM = 1 << 0,    // FieldTable::addFields
+  BIND_STATE = 1 << 1,   // FieldTable::read(..., BIND_STATE), e.g. a WS state frame
+  BIND_CONFIG = 1 << 2,  // FieldTable::read(..., BIND_CONFIG), e.g. FSPersistence
+  BIND_UPDATE = 1 << 3,  // accepted by FieldTable::update
+  BIND_ALL = BIND_FORM | BIND_STATE | BIND_CONFIG | BIND_UPDATE,
+};
+
+enum class FieldKind : uint8_t { BOOL, INT, FLOAT, STRING };
+
+// FNV-1a as wsPathHash, usable in constant expressions so the keys of a binding table are hashed by the compiler
+constexpr uint32_t fieldKeyHash(const char* key, uint32_t hash = 2166136261u) {
+  return *key ? fieldKeyHash(key + 1, (hash ^ (uint8_t)*key) * 16777619u) : hash;
+}
+
+/**
+ * One member of T exposed under a JSON key: its change mask bit, the FormBuilder descriptor of its widget (nullptr
+ * keeps it out of the forms) and the scopes it takes part in. Built with constexpr constructors, so a table of bindings
+ * is constant data:
+ *
+ *   static const FieldBinding<LightState> bindings[] = {
+ *       {"led_on", &LightState::ledOn, F_LED_ON, FB_O(FB_SWITCH, FB_RW)},
+ *       {"gain", &LightState::gain, F_GAIN, FB_O(FB_SLIDER, FB_RW, FB_MIN(10) FB_MAX(60)), BIND_FORM | BIND_UPDATE},
+ *   };
+ */
+template <class T>
+struct FieldBinding {
+  union Member {
+    bool T::*b;
+    int T::*i;
+    float T::*f;
+    String T::*s;
+    constexpr Member(bool T::*m) : b(m) {
+    }
+    constexpr Member(int T::*m) : i(m) {
+    }
+    constexpr Member(float T::*m) : f(m) {
+    }
+    constexpr Member(String T::*m) : s(m) {
+    }
+  };
+
+  const char* key;
+  uint32_t hash;
+  FieldKind kind;
+  Member member;
+  state_change_mask_t mask;
+  const char* descriptor;
+  uint8_t scope;
+
+  constexpr FieldBinding(const char* key,
+                         bool T::*member,
+                         state_change_mask_t mask,
+                         FieldDescriptor descriptor = FieldDescriptor{nullptr},
+                         uint8_t scope = BIND_ALL) :
+      key(key),
+      hash(fieldKeyHash(key)),
+      kind(FieldKind::BOOL),
+      member(member),
+      mask(mask),
+      descriptor(descriptor.o),
+      scope(scope) {
+  }
+  constexpr FieldBinding(const char* key,
+                         int T::*member,
+                         state_change_mask_t mask,
+                         FieldDescriptor descriptor = FieldDescriptor{nullptr},
+                         uint8_t scope = BIND_ALL) :
+      key(key),
+      hash(fieldKeyHash(key)),
+      kind(FieldKind::INT),
+      member(member),
+      mask(mask),
+      descriptor(descriptor.o),
+      scope(scope) {
+  }
+  constexpr FieldBinding(const char* key,
+                         float T::*member,
+                         state_change_mask_t mask,
+                         FieldDescriptor descriptor = FieldDescriptor{nullptr},
+                         uint8_t scope = BIND_ALL) :
+      key(key),
+      hash(fieldKeyHash(key)),
+      kind(FieldKind::FLOAT),
+      member(member),
+      mask(mask),
+      descriptor(descriptor.o),
+      scope(scope) {
+  }
+  constexpr FieldBinding(const char* key,
+                         String T::*member,
+                         state_change_mask_t mask,
+                         FieldDescriptor descriptor = FieldDescriptor{nullptr},
+                         uint8_t scope = BIND_ALL) :
+      key(key),
+      hash(fieldKeyHash(key)),
+      kind(FieldKind::STRING),
+      member(member),
+      mask(mask),
+      descriptor(descriptor.o),
+      scope(scope) {
+  }
+};
+
+/**
+ * Generates the JSON readers, the updater and the form fields of a state from its binding table.
+ *
+ * update() walks the received object once and finds each key through a perfect hash index over the precomputed key
+ * hashes, instead of probing every known key with containsKey. The index is a power of two of at least twice the
+ * bindings, with a multiplier seed searched once in the constructor so that no two keys share a slot; a lookup is one
+ * FNV-1a pass over the received key, one slot and one strcmp. Values are accepted as FormBuilder::updateValue accepts
+ * them: only of the member's JSON type, booleans only as true/false.
+ *
+ * Keep one table per state class, e.g. as a function-local static.
+ */
+template <class T>
+class FieldTable {
+ public:
+  template <size_t N>
+  explicit FieldTable(const FieldBinding<T> (&bindings)[N]) : _bindings(bindings), _count(N) {
+    static_assert(N < 255, "slot index is a uint8_t");
+    buildIndex();
+  }
+
+  const FieldBinding<T>* find(const char* key) const {
+    uint8_t index = _slots[slotOf(fieldKeyHash(key))];
+    if (index == EMPTY_SLOT) {
+      return nullptr;
+    }
+    const FieldBinding<T>& binding = _bindings[index];
+    return strcmp(binding.key, key) == 0 ? &binding : nullptr;
+  }
+
+  // plain key -> value object of the bindings in scope
+  void read(const T& state, JsonObject& root, uint8_t scope) const {
+    for (size_t i = 0; i < _count; i++) {
+      const FieldBinding<T>& binding = _bindings[i];
+      if (!(binding.scope & scope)) {
+        continue;
+      }
+      switch (binding.kind) {
+        case FieldKind::BOOL:
+          root[binding.key] = state.*binding.member.b;
+          break;
+        case FieldKind::INT:
+          root[binding.key] = state.*binding.member.i;
+          break;
+        case FieldKind::FLOAT:
+          root[binding.key] = state.*binding.member.f;
+          break;
+        case FieldKind::STRING:
+          root[binding.key] = state.*binding.member.s;
+          break;
+      }
+    }
+  }
+
+  StateUpdateResult update(JsonObject& root, T& state) const {
+    bool changed = false;
+    for (JsonPair pair : root) {
+      const FieldBinding<T>* binding = find(pair.key().c_str());
+      if (binding && (binding->scope & BIND_UPDATE) && apply(*binding, pair.value(), state)) {
+        StateChangeRecorder::record(binding->mask);
+        changed = true;
+      }
+    }
+    return changed ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
+  }
+
+  // one field per binding with a descriptor, into a FormDocumentWriter or a FormStreamWriter
+  template <class Form>
+  void addFields(const T& state, Form& form) const {
+    for (size_t i = 0; i < _count; i++) {
+      const FieldBinding<T>& binding = _bindings[i];
+      if (!binding.descriptor || !(binding.scope & BIND_FORM)) {
+        continue;
+      }
+      FieldDescriptor descriptor{binding.descriptor};
+      // number fields carry their value as a string, see FormBuilder::addNumberField
+      bool number = strncmp(binding.descriptor, FB_NUMBER ";", sizeof(FB_NUMBER)) == 0;
+      switch (binding.kind) {
+        case FieldKind::BOOL:
+          form.addField(binding.key, state.*binding.member.b, descriptor);
+          break;
+        case FieldKind::INT:
+          if (number) {
+            form.addNumberField(binding.key, (double)(state.*binding.member.i), descriptor);
+          } else {
+            form.addField(binding.key, state.*binding.member.i, descriptor);
+          }
+          break;
+        case FieldKind::FLOAT:
+          if (number) {
+            form.addNumberField(binding.key, (double)(state.*binding.member.f), descriptor);
+          } else {
+            form.addField(binding.key, state.*binding.member.f, descriptor);
+          }
+          break;
+        case FieldKind::STRING:
+          form.addField(binding.key, state.*binding.member.s, descriptor);
+          break;
+      }
+    }
+  }
+
+ private:
+  static constexpr uint8_t EMPTY_SLOT = 0xff;
+
+  const FieldBinding<T>* _bindings;
+  size_t _count;
+  std::vector<uint8_t> _slots;
+  uint32_t _seed;
+  uint8_t _shift;
+
+  size_t slotOf(uint32_t hash) const {
+    return (size_t)((hash * _seed) >> _shift);
+  }
+
+  void buildIndex() {
+    uint8_t bits = 1;
+    while ((1u << bits) < _count * 2) {
+      bits++;
+    }
+    for (;; bits++) {
+      _slots.assign(1u << bits, EMPTY_SLOT);
+      _shift = 32 - bits;
+      // odd multipliers from the golden ratio one, the top bits of hash * seed pick the slot
+      for (uint32_t attempt = 0; attempt < 256; attempt++) {
+        _seed = 2654435761u + attempt * 2;
+        if (placeAll()) {
+          return;
+        }
+      }
+    }
+  }
+
+  bool placeAll() {
+    std::fill(_slots.begin(), _slots.end(), EMPTY_SLOT);
+    for (size_t i = 0; i < _count; i++) {
+      uint8_t& slot = _slots[slotOf(_bindings[i].hash)];
+      if (slot != EMPTY_SLOT) {
+        if (_bindings[slot].hash == _bindings[i].hash) {
+          continue;  // the same key twice, no seed would separate them: the first binding wins
+        }
+        return false;
+      }
+      slot = (uint8_t)i;
+    }
+    return true;
+  }
+
+  static bool apply(const FieldBinding<T>& binding, JsonVariant value, T& state) {
+    switch (binding.kind) {
+      case FieldKind::BOOL:
+        return assign(state.*binding.member.b, value);
+      case FieldKind::INT:
+        return assign(state.*binding.member.i, value);
+      case FieldKind::FLOAT:
+        return assign(state.*binding.member.f, value);
+      case FieldKind::STRING:
+        return assign(state.*binding.member.s, value);
+    }
+    return false;
+  }
+
+  template <typename V>
+  static bool assign(V& member, JsonVariant value) {
+    if (!value.is<V>()) {
+      return false;
+    }
+    V received = value.as<V>();
+    if (received == member) {
+      return false;
+    }
+    member = received;
+    return true;
+  }
+};
+
+template <class T>
+constexpr uint8_t FieldTable<T>::EMPTY_SLOT;
+
+#endif  // end FieldBindings_h
@@ -2,6 +2,8 @@
 #define FORMBUILDER_H
 
 #include <ArduinoJson.h>
+#include <StatefulService.h>
+#include <FormFilter.h>
 #include <vector>
 #include <math.h>  // для sin, cos
 
@@ -116,6 +118,46 @@ inline const char* toString(FieldType ft) {
   return "unknown";
 }
 
+// ====================== Статичні дескриптори "o" ======================
+// Увесь дескриптор складається препроцесором із сусідніх літералів, тож це один рядок у .rodata (на ESP32 — у flash).
+// ArduinoJson зберігає const char* вказівником: поле з таким дескриптором не робить жодної алокації ні в heap, ні в
+// документі. Числа вставляються як написані в коді (FB_MIN(0) → "mn=0").
+//   FormBuilder::addNumberField(sta, "test_number", value, FB_O(FB_NUMBER, FB_RW, FB_MIN(0) FB_MAX(100) FB_FORMAT("0.00")));
+// Для значень, відомих лише під час виконання, лишаються варіанти з тегами (minVal(), opt(), lines(), ...).
+struct FieldDescriptor { const char* o; };
+
+#define FB_O(type, access, ...)   FieldDescriptor{type ";" access __VA_ARGS__}
+
+#define FB_TEXT      "text"
+#define FB_NUMBER    "number"
+#define FB_SLIDER    "slider"
+#define FB_CHECKBOX  "checkbox"
+#define FB_SWITCH    "switch"
+#define FB_DROPDOWN  "dropdown"
+#define FB_TEXTAREA  "textarea"
+#define FB_RADIO     "radio"
+#define FB_TREND     "trend"
+#define FB_BUTTON    "button"
+
+#define FB_R   "r"
+#define FB_RW  "rw"
+
+#define FB_MIN(v)            ";mn=" #v
+#define FB_MAX(v)            ";mx=" #v
+#define FB_STEP(v)           ";st=" #v
+#define FB_FORMAT(f)         ";f=" f
+#define FB_PLACEHOLDER(t)    ";pl=" t
+#define FB_OPTIONS(list)     ";options=" list          // "Option1,Option2"
+#define FB_MODE(m)           ";mode=" m                // для "barChart" xAxis — FB_XAXIS("keys")
+#define FB_XAXIS(k)          ";xAxis=" k
+#define FB_LINES(l)          ";lines=" l               // лінії через FB_LINE_SEP
+#define FB_LINE(k, color, type)         k ":color=" color ",type=" type
+#define FB_HIDDEN_LINE(k, color, type)  k ":hidden=true,color=" color ",type=" type
+#define FB_LINE_SEP          ";"
+#define FB_LEGEND            ";legend=true"
+#define FB_TOOLTIP           ";tooltip=true"
+#define FB_MAX_POINTS(n)     ";maxPoints=" #n
+
 // ====================== Парсер для number field ======================
 struct MinVal;  // forward
 static void parseNumberArg(MinVal m, double& mn, double&, const char*&) { mn = m.v; }
@@ -207,11 +249,23 @@ static void parseTrendArgs(String& xAxisKey, String& linesStr, bool& showLegend,
 class FormBuilder {
  public:
   static JsonArray createForm(JsonObject& root, const char* name, const char* description) {
+    if (FormFilter::skipsForm(name)) return JsonArray();   // поля такої форми теж пропускаються
     JsonObject form = root.createNestedObject(name);
     form["description"] = description;
     return form.createNestedArray("fields");
   }
 
+  // Схема форм без значень (див. FormSchemaEndpoint): значення кожного поля стає null, лишається лише "o"
+  static void stripValues(JsonObject& root) {
+    for (JsonPair form : root) {
+      for (JsonObject field : form.value()["fields"].as<JsonArray>()) {
+        for (JsonPair kv : field) {
+          if (kv.key() != "o") kv.value().clear();
+        }
+      }
+    }
+  }
+
   // Загальний оновлювач (для небулевих типів)
   template <typename T>
   static bool updateValue(JsonObject& root, const char* key, T& value) {
@@ -231,8 +285,16 @@ class FormBuilder {
     return false;
   }
 
+  // Те саме + позначає біт поля у масці змін (StateChangeRecorder) для update handler-ів
+  template <typename T>
+  static bool updateValue(JsonObject& root, const char* key, T& value, state_change_mask_t field) {
+    if (updateValue(root, key, value)) { StateChangeRecorder::record(field); return true; }
+    return false;
+  }
+
   // ---------- TEXT ----------
   static JsonObject addTextField(JsonArray& fields, const char* key, AF accessFlag, const char* val) {
+    if (FormFilter::skipsField(key)) return JsonObject();  // не запитане в ?form= / ?fields= (FormFilter)
     JsonObject field = fields.createNestedObject();
     field[key] = val;
     setBasicOptions(field, FieldType::TEXT, accessFlag);
@@ -242,17 +304,12 @@ class FormBuilder {
   // ---------- NUMBER ----------
   template <typename... Args>
   static JsonObject addNumberField(JsonArray& fields, const char* key, AF accessFlag, double value, Args... numberArgs) {
-    double mn = 0, mx = 100; const char* fmt = "";
-    parseNumberArgs(mn, mx, fmt, numberArgs...);
-
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = String(value);  // сумісність із поточним фронтом (value як рядок)
 
-    String oValue = String(toString(FieldType::NUMBER)) + ";" + toString(accessFlag);
-    oValue += ";mn="; oValue += mn;
-    oValue += ";mx="; oValue += mx;
-    if (fmt && fmt[0] != '\0') { oValue += ";f="; oValue += fmt; }
-
+    String oValue;
+    numberDescriptor(oValue, accessFlag, numberArgs...);
     field["o"] = oValue;
     return field;
   }
@@ -260,24 +317,19 @@ class FormBuilder {
   // ---------- SLIDER ----------
   template <typename... Args>
   static JsonObject addSliderField(JsonArray& fields, const char* key, AF accessFlag, double value, Args... sliderArgs) {
-    double mn = 0, mx = 100, st = 1; const char* pl = nullptr;
-    parseSliderArgs(mn, mx, st, pl, sliderArgs...);
-
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = value; // числом
 
-    String oValue = String(toString(FieldType::SLIDER)) + ";" + toString(accessFlag);
-    oValue += ";mn="; oValue += mn;
-    oValue += ";mx="; oValue += mx;
-    if (!std::isnan(st)) { oValue += ";st="; oValue += st; }
-    if (pl && pl[0] != '\0') { oValue += ";pl="; oValue += pl; }
-
+    String oValue;
+    sliderDescriptor(oValue, accessFlag, sliderArgs...);
     field["o"] = oValue;
     return field;
   }
 
   // ---------- CHECKBOX (boolean) ----------
   static JsonObject addCheckboxField(JsonArray& fields, const char* key, AF accessFlag, bool value) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = value;  // ЛИШЕ true/false
     setBasicOptions(field, FieldType::CHECKBOX, accessFlag);
@@ -286,6 +338,7 @@ class FormBuilder {
 
   // ---------- SWITCH (boolean) ----------
   static JsonObject addSwitchField(JsonArray& fields, const char* key, AF accessFlag, bool value) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = value;  // ЛИШЕ true/false
     setBasicOptions(field, FieldType::SWITCH, accessFlag);
@@ -295,15 +348,12 @@ class FormBuilder {
   // ---------- BUTTON (boolean) ----------
   template <typename... Args>
   static JsonObject addButtonField(JsonArray& fields, const char* key, AF accessFlag, bool value, Args... btnArgs) {
-    const char* pl = nullptr;
-    parseButtonArgs(pl, btnArgs...);
-
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = value;  // ЛИШЕ true/false
 
-    String oValue = String(toString(FieldType::BUTTON)) + ";" + toString(accessFlag);
-    if (pl && pl[0] != '\0') { oValue += ";pl="; oValue += pl; }
-
+    String oValue;
+    buttonDescriptor(oValue, accessFlag, btnArgs...);
     field["o"] = oValue;
     return field;
   }
@@ -311,29 +361,19 @@ class FormBuilder {
   // ---------- DROPDOWN ----------
   template <typename... Args>
   static JsonObject addDropdownField(JsonArray& fields, const char* key, AF accessFlag, int selectedValue, Args... optArgs) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = selectedValue;
 
-    std::vector<Opt> options;
-    parseOptionsArgs(options, optArgs...);
-
-    String oValue = String(toString(FieldType::DROPDOWN)) + ";" + toString(accessFlag);
-    if (!options.empty()) {
-      oValue += ";options=";
-      bool first = true;
-      for (auto& op : options) {
-        if (!first) oValue += ",";
-        oValue += op.label;
-        first = false;
-      }
-    }
-
+    String oValue;
+    optionsDescriptor(oValue, FieldType::DROPDOWN, accessFlag, optArgs...);
     field["o"] = oValue;
     return field;
   }
 
   // ---------- TEXTAREA ----------
   static JsonObject addTextareaField(JsonArray& fields, const char* key, AF accessFlag, const String& value) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = value;
     setBasicOptions(field, FieldType::TEXTAREA, accessFlag);
@@ -343,23 +383,12 @@ class FormBuilder {
   // ---------- RADIO ----------
   template <typename... Args>
   static JsonObject addRadioField(JsonArray& fields, const char* key, AF accessFlag, int selectedValue, Args... optArgs) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = selectedValue;
 
-    std::vector<Opt> options;
-    parseOptionsArgs(options, optArgs...);
-
-    String oValue = String(toString(FieldType::RADIO)) + ";" + toString(accessFlag);
-    if (!options.empty()) {
-      oValue += ";options=";
-      bool first = true;
-      for (auto& op : options) {
-        if (!first) oValue += ",";
-        oValue += op.label;
-        first = false;
-      }
-    }
-
+    String oValue;
+    optionsDescriptor(oValue, FieldType::RADIO, accessFlag, optArgs...);
     field["o"] = oValue;
     return field;
   }
@@ -367,43 +396,207 @@ class FormBuilder {
   // ---------- TREND ----------
   template <typename... Args>
   static JsonObject addTrendField(JsonArray& fields, const char* key, AF accessFlag, Args... trendArgs) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     JsonObject trendObj = field.createNestedObject(key); (void)trendObj; // зарезервовано для сумісності
 
-    String xAxisKeyStr = "timestamp";
-    String linesStr;
-    bool showLegend = false, showTooltip = false;
-    int maxPts = 100;
-    String modeStr = "lineChart";
+    String oValue;
+    trendDescriptor(oValue, accessFlag, trendArgs...);
+    field["o"] = oValue;
+    return field;
+  }
 
-    parseTrendArgs(xAxisKeyStr, linesStr, showLegend, showTooltip, maxPts, modeStr, trendArgs...);
+  // ---------- Поля зі статичним дескриптором (FB_O) ----------
+  template <typename V>
+  static JsonObject addField(JsonArray& fields, const char* key, const V& value, FieldDescriptor descriptor) {
+    if (FormFilter::skipsField(key)) return JsonObject();
+    JsonObject field = fields.createNestedObject();
+    field[key] = value;
+    field["o"] = descriptor.o;  // вказівник на літерал, без копії
+    return field;
+  }
 
-    String oValue = String(toString(FieldType::TREND)) + ";" + toString(accessFlag);
-    oValue += ";mode=";  oValue += modeStr;
-    if (modeStr == "barChart") { oValue += ";xAxis=keys"; }
-    else { oValue += ";xAxis="; oValue += xAxisKeyStr; }
-    if (linesStr.length() > 0) { oValue += ";lines="; oValue += linesStr; }
-    if (showLegend)  oValue += ";legend=true";
-    if (showTooltip) oValue += ";tooltip=true";
-    if (maxPts > 0)  { oValue += ";maxPoints="; oValue += maxPts; }
+  static JsonObject addNumberField(JsonArray& fields, const char* key, double value, FieldDescriptor descriptor) {
+    if (FormFilter::skipsField(key)) return JsonObject();  // до String(value)
+    return addField(fields, key, String(value), descriptor);  // value рядком, як у варіанті з тегами
+  }
 
-    field["o"] = oValue;
+  static JsonObject addTrendField(JsonArray& fields, const char* key, FieldDescriptor descriptor) {
+    if (FormFilter::skipsField(key)) return JsonObject();
+    JsonObject field = fields.createNestedObject();
+    field.createNestedObject(key);
+    field["o"] = descriptor.o;
     return field;
   }
 
   // ---------- DEFAULT ----------
   static JsonObject addDefaultField(JsonArray& fields, const char* key, AF accessFlag, const char* value) {
+    if (FormFilter::skipsField(key)) return JsonObject();
     JsonObject field = fields.createNestedObject();
     field[key] = value;
     setBasicOptions(field, FieldType::UNKNOWN, accessFlag);
     return field;
   }
 
+  // ---------- Дескриптори "o" з тегів ----------
+  // Out — String (add*Field) або будь-що з += для const char*, String, double та int (FormStreamWriter).
+  template <class Out, typename... Args>
+  static void numberDescriptor(Out& o, AF accessFlag, Args... numberArgs) {
+    double mn = 0, mx = 100; const char* fmt = "";
+    parseNumberArgs(mn, mx, fmt, numberArgs...);
+    o += basicDescriptor(FieldType::NUMBER, accessFlag);
+    o += ";mn="; o += mn;
+    o += ";mx="; o += mx;
+    if (fmt && fmt[0] != '\0') { o += ";f="; o += fmt; }
+  }
+
+  template <class Out, typename... Args>
+  static void sliderDescriptor(Out& o, AF accessFlag, Args... sliderArgs) {
+    double mn = 0, mx = 100, st = 1; const char* pl = nullptr;
+    parseSliderArgs(mn, mx, st, pl, sliderArgs...);
+    o += basicDescriptor(FieldType::SLIDER, accessFlag);
+    o += ";mn="; o += mn;
+    o += ";mx="; o += mx;
+    if (!std::isnan(st)) { o += ";st="; o += st; }
+    if (pl && pl[0] != '\0') { o += ";pl="; o += pl; }
+  }
+
+  template <class Out, typename... Args>
+  static void buttonDescriptor(Out& o, AF accessFlag, Args... btnArgs) {
+    const char* pl = nullptr;
+    parseButtonArgs(pl, btnArgs...);
+    o += basicDescriptor(FieldType::BUTTON, accessFlag);
+    if (pl && pl[0] != '\0') { o += ";pl="; o += pl; }
+  }
+
+  // dropdown і radio
+  template <class Out, typename... Args>
+  static void optionsDescriptor(Out& o, FieldType ft, AF accessFlag, Args... optArgs) {
+    std::vector<Opt> options;
+    parseOptionsArgs(options, optArgs...);
+    o += basicDescriptor(ft, accessFlag);
+    if (!options.empty()) {
+      o += ";options=";
+      bool first = true;
+      for (auto& op : options) {
+        if (!first) o += ",";
+        o += op.label;
+        first = false;
+      }
+    }
+  }
+
+  template <class Out, typename... Args>
+  static void trendDescriptor(Out& o, AF accessFlag, Args... trendArgs) {
+    String xAxisKeyStr = "timestamp";
+    String linesStr;
+    bool showLegend = false, showTooltip = false;
+    int maxPts = 100;
+    String modeStr = "lineChart";
+
+    parseTrendArgs(xAxisKeyStr, linesStr, showLegend, showTooltip, maxPts, modeStr, trendArgs...);
+
+    o += basicDescriptor(FieldType::TREND, accessFlag);
+    o += ";mode=";  o += modeStr;
+    if (modeStr == "barChart") { o += ";xAxis=keys"; }
+    else { o += ";xAxis="; o += xAxisKeyStr; }
+    if (linesStr.length() > 0) { o += ";lines="; o += linesStr; }
+    if (showLegend)  o += ";legend=true";
+    if (showTooltip) o += ";tooltip=true";
+    if (maxPts > 0)  { o += ";maxPoints="; o += maxPts; }
+  }
+
+  // "тип;доступ" без параметрів — готовий літерал замість склеювання String
+  static const char* basicDescriptor(FieldType ft, AF af) {
+    bool rw = af == AF::RW;
+    switch (ft) {
+      case FieldType::TEXT:     return rw ? FB_TEXT ";" FB_RW     : FB_TEXT ";" FB_R;
+      case FieldType::NUMBER:   return rw ? FB_NUMBER ";" FB_RW   : FB_NUMBER ";" FB_R;
+      case FieldType::SLIDER:   return rw ? FB_SLIDER ";" FB_RW   : FB_SLIDER ";" FB_R;
+      case FieldType::CHECKBOX: return rw ? FB_CHECKBOX ";" FB_RW : FB_CHECKBOX ";" FB_R;
+      case FieldType::SWITCH:   return rw ? FB_SWITCH ";" FB_RW   : FB_SWITCH ";" FB_R;
+      case FieldType::DROPDOWN: return rw ? FB_DROPDOWN ";" FB_RW : FB_DROPDOWN ";" FB_R;
+      case FieldType::TEXTAREA: return rw ? FB_TEXTAREA ";" FB_RW : FB_TEXTAREA ";" FB_R;
+      case FieldType::RADIO:    return rw ? FB_RADIO ";" FB_RW    : FB_RADIO ";" FB_R;
+      case FieldType::TREND:    return rw ? FB_TREND ";" FB_RW    : FB_TREND ";" FB_R;
+      case FieldType::BUTTON:   return rw ? FB_BUTTON ";" FB_RW   : FB_BUTTON ";" FB_R;
+      case FieldType::UNKNOWN:  break;
+    }
+    return rw ? "unknown;rw" : "unknown;r";
+  }
+
  private:
   static void setBasicOptions(JsonObject& field, FieldType ft, AF af) {
-    String oValue = String(toString(ft)) + ";" + toString(af);
-    field["o"] = oValue;
+    field["o"] = basicDescriptor(ft, af);
+  }
+};
+
+// ====================== FormDocumentWriter ======================
+// Ті самі add*Field, що й у FormBuilder, але як методи: форма, описана шаблоном над writer-ом
+//   template <class Form> static void forms(S& s, Form& f) { f.createForm(...); f.addSwitchField(...); }
+// будується і в JsonObject (FormDocumentWriter), і потоком без документа (FormStreamWriter, FormStream.h).
+class FormDocumentWriter {
+ public:
+  explicit FormDocumentWriter(JsonObject& root) : _root(root) {}
+
+  void createForm(const char* name, const char* description) {
+    _fields = FormBuilder::createForm(_root, name, description);
+  }
+
+  void addTextField(const char* key, AF accessFlag, const char* val) {
+    FormBuilder::addTextField(_fields, key, accessFlag, val);
+  }
+  template <typename... Args>
+  void addNumberField(const char* key, AF accessFlag, double value, Args... numberArgs) {
+    FormBuilder::addNumberField(_fields, key, accessFlag, value, numberArgs...);
+  }
+  template <typename... Args>
+  void addSliderField(const char* key, AF accessFlag, double value, Args... sliderArgs) {
+    FormBuilder::addSliderField(_fields, key, accessFlag, value, sliderArgs...);
+  }
+  void addCheckboxField(const char* key, AF accessFlag, bool value) {
+    FormBuilder::addCheckboxField(_fields, key, accessFlag, value);
+  }
+  void addSwitchField(const char* key, AF accessFlag, bool value) {
+    FormBuilder::addSwitchField(_fields, key, accessFlag, value);
+  }
+  template <typename... Args>
+  void addButtonField(const char* key, AF accessFlag, bool value, Args... btnArgs) {
+    FormBuilder::addButtonField(_fields, key, accessFlag, value, btnArgs...);
+  }
+  template <typename... Args>
+  void addDropdownField(const char* key, AF accessFlag, int selectedValue, Args... optArgs) {
+    FormBuilder::addDropdownField(_fields, key, accessFlag, selectedValue, optArgs...);
+  }
+  void addTextareaField(const char* key, AF accessFlag, const String& value) {
+    FormBuilder::addTextareaField(_fields, key, accessFlag, value);
+  }
+  template <typename... Args>
+  void addRadioField(const char* key, AF accessFlag, int selectedValue, Args... optArgs) {
+    FormBuilder::addRadioField(_fields, key, accessFlag, selectedValue, optArgs...);
+  }
+  template <typename... Args>
+  void addTrendField(const char* key, AF accessFlag, Args... trendArgs) {
+    FormBuilder::addTrendField(_fields, key, accessFlag, trendArgs...);
   }
+  void addDefaultField(const char* key, AF accessFlag, const char* value) {
+    FormBuilder::addDefaultField(_fields, key, accessFlag, value);
+  }
+
+  template <typename V>
+  void addField(const char* key, const V& value, FieldDescriptor descriptor) {
+    FormBuilder::addField(_fields, key, value, descriptor);
+  }
+  void addNumberField(const char* key, double value, FieldDescriptor descriptor) {
+    FormBuilder::addNumberField(_fields, key, value, descriptor);
+  }
+  void addTrendField(const char* key, FieldDescriptor descriptor) {
+    FormBuilder::addTrendField(_fields, key, descriptor);
+  }
+
+ private:
+  JsonObject& _root;
+  JsonArray _fields;
 };
 
 #endif  // FORMBUILDER_H
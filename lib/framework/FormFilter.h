@@ -0,0 +1,72 @@
+#ifndef FormFilter_h
+#define FormFilter_h
+
+#include <Arduino.h>
+
+#include <StatefulService.h>
+
+/**
+ * Limits the forms and fields that FormBuilder renders while an instance exists, for GET ?form=status&fields=a,b.
+ *
+ * Like StateChangeRecorder it is installed for the current thread by its constructor and consulted by the builders:
+ * FormBuilder::createForm, the add*Field functions and FormStreamWriter skip a form or field that was not asked for
+ * before building anything for it. Both lists are comma separated, an empty list does not limit. The strings must
+ * outlive the filter.
+ */
+class FormFilter {
+ public:
+  FormFilter(const String& forms, const String& fields) :
+      _forms(forms), _fields(fields), _formSkipped(false), _previous(current()) {
+    current() = this;
+  }
+  ~FormFilter() {
+    current() = _previous;
+  }
+
+  // called for every form, the fields that follow are skipped along with a skipped form
+  static bool skipsForm(const char* name) {
+    FormFilter* filter = current();
+    if (!filter) {
+      return false;
+    }
+    filter->_formSkipped = !listed(filter->_forms, name);
+    return filter->_formSkipped;
+  }
+
+  static bool skipsField(const char* key) {
+    FormFilter* filter = current();
+    return filter && (filter->_formSkipped || !listed(filter->_fields, key));
+  }
+
+ private:
+  const String& _forms;
+  const String& _fields;
+  bool _formSkipped;
+  FormFilter* _previous;
+
+  static FormFilter*& current() {
+    static STATE_CHANGE_THREAD_LOCAL FormFilter* filter = nullptr;
+    return filter;
+  }
+
+  static bool listed(const String& list, const char* item) {
+    if (!list.length()) {
+      return true;
+    }
+    size_t length = strlen(item);
+    const char* entry = list.c_str();
+    for (;;) {
+      const char* end = strchr(entry, ',');
+      size_t entryLength = end ? (size_t)(end - entry) : strlen(entry);
+      if (entryLength == length && strncmp(entry, item, length) == 0) {
+        return true;
+      }
+      if (!end) {
+        return false;
+      }
+      entry = end + 1;
+    }
+  }
+};
+
+#endif  // end FormFilter_h
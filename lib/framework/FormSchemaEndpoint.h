@@ -0,0 +1,102 @@
+#ifndef FormSchemaEndpoint_h
+#define FormSchemaEndpoint_h
+
+#include <functional>
+
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+
+#include <FSPersistenceChecksum.h>
+#include <FormBuilder.h>
+#include <HttpEndpoint.h>
+
+/**
+ * Serves the FormBuilder forms of a state in two parts, so a page load only computes and transfers the values:
+ *
+ *   GET schemaPath - the forms with their "o" descriptors and every field value null. Built once from the form
+ *                    reader and kept serialized, with its CRC-32 as a strong ETag; a request whose If-None-Match
+ *                    carries that ETag gets 304 without a body.
+ *   GET valuesPath - flat key -> value object written by the values reader on every request.
+ *
+ * The paths must not be below the path of the service's HttpEndpoint, which would catch them first. The complete
+ * forms stay available from the HttpEndpoint for clients that do not merge the two parts.
+ */
+template <class T>
+class FormSchemaEndpoint {
+ public:
+  FormSchemaEndpoint(JsonStateReader<T> formReader,
+                     JsonStateReader<T> valuesReader,
+                     StatefulService<T>* statefulService,
+                     AsyncWebServer* server,
+                     const String& schemaPath,
+                     const String& valuesPath,
+                     SecurityManager* securityManager,
+                     AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
+                     size_t bufferSize = DEFAULT_BUFFER_SIZE) :
+      _formReader(formReader),
+      _valuesReader(valuesReader),
+      _statefulService(statefulService),
+      _schemaCapacity("GET " + schemaPath, bufferSize),
+      _valuesCapacity("GET " + valuesPath, bufferSize) {
+    server->on(schemaPath.c_str(),
+               HTTP_GET,
+               securityManager->wrapRequest(std::bind(&FormSchemaEndpoint::fetchSchema, this, std::placeholders::_1),
+                                            authenticationPredicate));
+    server->on(valuesPath.c_str(),
+               HTTP_GET,
+               securityManager->wrapRequest(std::bind(&FormSchemaEndpoint::fetchValues, this, std::placeholders::_1),
+                                            authenticationPredicate));
+  }
+
+  const String& etag() {
+    buildSchema();
+    return _etag;
+  }
+
+ protected:
+  JsonStateReader<T> _formReader;
+  JsonStateReader<T> _valuesReader;
+  StatefulService<T>* _statefulService;
+  JsonCapacity _schemaCapacity;
+  JsonCapacity _valuesCapacity;
+  String _schema;
+  String _etag;
+
+  void fetchSchema(AsyncWebServerRequest* request) {
+    buildSchema();
+    AsyncWebServerResponse* response;
+    if (request->hasHeader("If-None-Match") && request->header("If-None-Match").indexOf(_etag) >= 0) {
+      response = request->beginResponse(304);
+    } else {
+      // the body stays in _schema, which is never rebuilt
+      response = request->beginResponse(200, JSON_MIMETYPE, (const uint8_t*)_schema.c_str(), _schema.length());
+    }
+    response->addHeader("ETag", _etag);
+    // the browser keeps its copy but asks every time, a firmware update changes the ETag
+    response->addHeader("Cache-Control", "no-cache");
+    request->send(response);
+  }
+
+  void fetchValues(AsyncWebServerRequest* request) {
+    sendStateResponse(request, _statefulService, _valuesReader, _valuesCapacity);
+  }
+
+  void buildSchema() {
+    if (_schema.length()) {
+      return;
+    }
+    DynamicJsonDocument document = _schemaCapacity.fill([&](JsonDocument& schema) {
+      JsonObject root = schema.to<JsonObject>();
+      _statefulService->read(root, _formReader);
+      FormBuilder::stripValues(root);
+    });
+    _schema.reserve(measureJson(document));
+    serializeJson(document, _schema);
+
+    char etag[11];
+    snprintf(etag, sizeof(etag), "\"%08x\"", (unsigned)crc32Update(0, (const uint8_t*)_schema.c_str(), _schema.length()));
+    _etag = etag;
+  }
+};
+
+#endif  // end FormSchemaEndpoint_h
@@ -0,0 +1,400 @@
+#ifndef FormStream_h
+#define FormStream_h
+
+#include <functional>
+#include <memory>
+
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+
+#include <FormBuilder.h>
+#include <FormFilter.h>
+#include <SecurityManager.h>
+#include <StatefulService.h>
+
+/**
+ * Window of a rendered response: keeps the bytes from offset `skip` until the buffer is full and drops the rest.
+ */
+class FormStreamSink {
+ public:
+  FormStreamSink(uint8_t* buffer, size_t maxLen, size_t skip) : _buffer(buffer), _maxLen(maxLen), _skip(skip), _len(0) {
+  }
+
+  void write(const char* data, size_t len) {
+    if (_len == _maxLen) {
+      return;
+    }
+    if (_skip) {
+      size_t skipped = len < _skip ? len : _skip;
+      data += skipped;
+      len -= skipped;
+      _skip -= skipped;
+    }
+    size_t copied = len < _maxLen - _len ? len : _maxLen - _len;
+    memcpy(_buffer + _len, data, copied);
+    _len += copied;
+  }
+
+  size_t length() const {
+    return _len;
+  }
+
+ private:
+  uint8_t* _buffer;
+  size_t _maxLen;
+  size_t _skip;
+  size_t _len;
+};
+
+/**
+ * Writes FormBuilder forms as JSON tokens straight into a FormStreamSink, with the same add*Field calls as
+ * FormDocumentWriter and the same JSON as FormBuilder serialized through a document.
+ *
+ * Nothing is kept besides a few counters, so the size of a form is not bounded by RAM.
+ */
+class FormStreamWriter {
+ public:
+  explicit FormStreamWriter(FormStreamSink& sink) : _sink(sink), _forms(0), _fields(0), _escaped(*this) {
+  }
+
+  void createForm(const char* name, const char* description) {
+    if (FormFilter::skipsForm(name)) {
+      return;
+    }
+    raw(_forms++ ? "]}," : "{");
+    string(name);
+    raw(":{\"description\":");
+    string(description);
+    raw(",\"fields\":[");
+    _fields = 0;
+  }
+
+  // closes the last form and the root object
+  void end() {
+    raw(_forms ? "]}}" : "{}");
+  }
+
+  void addTextField(const char* key, AF accessFlag, const char* val) {
+    basicField(key, val, FieldType::TEXT, accessFlag);
+  }
+
+  template <typename... Args>
+  void addNumberField(const char* key, AF accessFlag, double value, Args... numberArgs) {
+    if (!beginField(key)) {
+      return;
+    }
+    fixed(value);
+    beginDescriptor();
+    FormBuilder::numberDescriptor(_escaped, accessFlag, numberArgs...);
+    endField();
+  }
+
+  template <typename... Args>
+  void addSliderField(const char* key, AF accessFlag, double value, Args... sliderArgs) {
+    if (!beginField(key)) {
+      return;
+    }
+    writeValue(value);
+    beginDescriptor();
+    FormBuilder::sliderDescriptor(_escaped, accessFlag, sliderArgs...);
+    endField();
+  }
+
+  void addCheckboxField(const char* key, AF accessFlag, bool value) {
+    basicField(key, value, FieldType::CHECKBOX, accessFlag);
+  }
+
+  void addSwitchField(const char* key, AF accessFlag, bool value) {
+    basicField(key, value, FieldType::SWITCH, accessFlag);
+  }
+
+  template <typename... Args>
+  void addButtonField(const char* key, AF accessFlag, bool value, Args... btnArgs) {
+    if (!beginField(key)) {
+      return;
+    }
+    writeValue(value);
+    beginDescriptor();
+    FormBuilder::buttonDescriptor(_escaped, accessFlag, btnArgs...);
+    endField();
+  }
+
+  template <typename... Args>
+  void addDropdownField(const char* key, AF accessFlag, int selectedValue, Args... optArgs) {
+    if (!beginField(key)) {
+      return;
+    }
+    writeValue(selectedValue);
+    beginDescriptor();
+    FormBuilder::optionsDescriptor(_escaped, FieldType::DROPDOWN, accessFlag, optArgs...);
+    endField();
+  }
+
+  void addTextareaField(const char* key, AF accessFlag, const String& value) {
+    basicField(key, value, FieldType::TEXTAREA, accessFlag);
+  }
+
+  template <typename... Args>
+  void addRadioField(const char* key, AF accessFlag, int selectedValue, Args... optArgs) {
+    if (!beginField(key)) {
+      return;
+    }
+    writeValue(selectedValue);
+    beginDescriptor();
+    FormBuilder::optionsDescriptor(_escaped, FieldType::RADIO, accessFlag, optArgs...);
+    endField();
+  }
+
+  template <typename... Args>
+  void addTrendField(const char* key, AF accessFlag, Args... trendArgs) {
+    if (!beginField(key)) {
+      return;
+    }
+    raw("{}");
+    beginDescriptor();
+    FormBuilder::trendDescriptor(_escaped, accessFlag, trendArgs...);
+    endField();
+  }
+
+  void addDefaultField(const char* key, AF accessFlag, const char* value) {
+    basicField(key, value, FieldType::UNKNOWN, accessFlag);
+  }
+
+  template <typename V>
+  void addField(const char* key, const V& value, FieldDescriptor descriptor) {
+    if (!beginField(key)) {
+      return;
+    }
+    writeValue(value);
+    beginDescriptor();
+    _escaped += descriptor.o;
+    endField();
+  }
+
+  void addNumberField(const char* key, double value, FieldDescriptor descriptor) {
+    if (!beginField(key)) {
+      return;
+    }
+    fixed(value);
+    beginDescriptor();
+    _escaped += descriptor.o;
+    endField();
+  }
+
+  void addTrendField(const char* key, FieldDescriptor descriptor) {
+    if (!beginField(key)) {
+      return;
+    }
+    raw("{}");
+    beginDescriptor();
+    _escaped += descriptor.o;
+    endField();
+  }
+
+  // appends to the content of a JSON string, the Out of the FormBuilder::*Descriptor templates
+  class Escaped {
+   public:
+    explicit Escaped(FormStreamWriter& writer) : _writer(writer) {
+    }
+    Escaped& operator+=(const char* text) {
+      _writer.escape(text);
+      return *this;
+    }
+    Escaped& operator+=(const String& text) {
+      _writer.escape(text.c_str());
+      return *this;
+    }
+    // same digits as String::operator+=(double)
+    Escaped& operator+=(double number) {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%.2f", number);
+      _writer.raw(buffer);
+      return *this;
+    }
+    Escaped& operator+=(int number) {
+      char buffer[12];
+      snprintf(buffer, sizeof(buffer), "%d", number);
+      _writer.raw(buffer);
+      return *this;
+    }
+
+   private:
+    FormStreamWriter& _writer;
+  };
+
+ private:
+  FormStreamSink& _sink;
+  uint16_t _forms;
+  uint16_t _fields;
+  Escaped _escaped;
+
+  template <typename V>
+  void basicField(const char* key, const V& value, FieldType ft, AF accessFlag) {
+    if (!beginField(key)) {
+      return;
+    }
+    writeValue(value);
+    beginDescriptor();
+    _escaped += FormBuilder::basicDescriptor(ft, accessFlag);
+    endField();
+  }
+
+  // false for a field the FormFilter skips, the caller then writes nothing
+  bool beginField(const char* key) {
+    if (FormFilter::skipsField(key)) {
+      return false;
+    }
+    raw(_fields++ ? ",{" : "{");
+    string(key);
+    raw(":");
+    return true;
+  }
+
+  void beginDescriptor() {
+    raw(",\"o\":\"");
+  }
+
+  void endField() {
+    raw("\"}");
+  }
+
+  void writeValue(bool flag) {
+    raw(flag ? "true" : "false");
+  }
+
+  void writeValue(const char* text) {
+    if (text) {
+      string(text);
+    } else {
+      raw("null");
+    }
+  }
+
+  void writeValue(const String& text) {
+    string(text.c_str());
+  }
+
+  // numbers are formatted by ArduinoJson itself, a scalar takes nothing from the pool
+  template <typename V>
+  void writeValue(V number) {
+    StaticJsonDocument<16> document;
+    document.set(number);
+    char buffer[32];
+    _sink.write(buffer, serializeJson(document, buffer, sizeof(buffer)));
+  }
+
+  // String(double) in quotes, the value FormBuilder::addNumberField stores
+  void fixed(double number) {
+    raw("\"");
+    _escaped += number;
+    raw("\"");
+  }
+
+  void raw(const char* text) {
+    _sink.write(text, strlen(text));
+  }
+
+  void string(const char* text) {
+    raw("\"");
+    escape(text);
+    raw("\"");
+  }
+
+  // JSON string escaping, unescaped runs are written in one piece
+  void escape(const char* text) {
+    const char* run = text;
+    for (; *text; text++) {
+      char c = *text;
+      const char* replacement = nullptr;
+      char unicode[7];
+      switch (c) {
+        case '"': replacement = "\\\""; break;
+        case '\\': replacement = "\\\\"; break;
+        case '\b': replacement = "\\b"; break;
+        case '\f': replacement = "\\f"; break;
+        case '\n': replacement = "\\n"; break;
+        case '\r': replacement = "\\r"; break;
+        case '\t': replacement = "\\t"; break;
+        default:
+          if ((uint8_t)c < 0x20) {
+            snprintf(unicode, sizeof(unicode), "\\u%04x", (unsigned)c);
+            replacement = unicode;
+          }
+      }
+      if (replacement) {
+        _sink.write(run, text - run);
+        raw(replacement);
+        run = text + 1;
+      }
+    }
+    _sink.write(run, text - run);
+  }
+};
+
+template <typename T>
+using FormStreamReader = std::function<void(const T& state, FormStreamWriter& form)>;
+
+/**
+ * Sends the forms as a chunked response without building a document, limited by ?form= and ?fields= (FormFilter).
+ *
+ * The request holds the published snapshot of the service, or a copy of the state when snapshots are off, then every
+ * chunk renders the forms of it again from the start and keeps only its own window of bytes. Peak memory is that state
+ * plus the chunk buffer of the server, at the price of rendering the forms once per chunk. The reader must therefore write the same output for the same state.
+ */
+template <class T>
+void sendFormStream(AsyncWebServerRequest* request, StatefulService<T>* statefulService, FormStreamReader<T>* reader) {
+  std::shared_ptr<const T> state = statefulService->snapshot();
+  if (!state) {
+    statefulService->read([&](T& current) { state = std::make_shared<T>(current); });
+  }
+  String forms = request->arg("form");
+  String fields = request->arg("fields");
+  request->send(request->beginChunkedResponse(
+      JSON_MIMETYPE, [state, reader, forms, fields](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        FormFilter filter(forms, fields);
+        FormStreamSink sink(buffer, maxLen, index);
+        FormStreamWriter form(sink);
+        (*reader)(*state, form);
+        form.end();
+        return sink.length();
+      }));
+}
+
+/**
+ * GET endpoint for forms written with FormStreamWriter, a replacement for HttpGetEndpoint when the forms approach
+ * DEFAULT_BUFFER_SIZE. Updates stay with an HttpPostEndpoint on the same path.
+ */
+template <class T>
+class FormStreamEndpoint {
+ public:
+  FormStreamEndpoint(FormStreamReader<T> formReader,
+                     StatefulService<T>* statefulService,
+                     AsyncWebServer* server,
+                     const String& servicePath,
+                     SecurityManager* securityManager,
+                     AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN) :
+      _formReader(formReader), _statefulService(statefulService) {
+    server->on(servicePath.c_str(),
+               HTTP_GET,
+               securityManager->wrapRequest(std::bind(&FormStreamEndpoint::fetchForms, this, std::placeholders::_1),
+                                            authenticationPredicate));
+  }
+
+  FormStreamEndpoint(FormStreamReader<T> formReader,
+                     StatefulService<T>* statefulService,
+                     AsyncWebServer* server,
+                     const String& servicePath) :
+      _formReader(formReader), _statefulService(statefulService) {
+    server->on(servicePath.c_str(), HTTP_GET, std::bind(&FormStreamEndpoint::fetchForms, this, std::placeholders::_1));
+  }
+
+ protected:
+  FormStreamReader<T> _formReader;
+  StatefulService<T>* _statefulService;
+
+  void fetchForms(AsyncWebServerRequest* request) {
+    sendFormStream(request, _statefulService, &_formReader);
+  }
+};
+
+#endif  // end FormStream_h
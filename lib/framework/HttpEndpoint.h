@@ -6,11 +6,28 @@
 #include <AsyncJson.h>
 #include <ESPAsyncWebServer.h>
 
+#include <FormFilter.h>
+#include <JsonCapacity.h>
 #include <SecurityManager.h>
 #include <StatefulService.h>
 
 #define HTTP_ENDPOINT_ORIGIN_ID "http"
 
+// reads the state into a document sized by the endpoint's capacity policy and streams it out
+template <class T>
+void sendStateResponse(AsyncWebServerRequest* request,
+                       StatefulService<T>* statefulService,
+                       JsonStateReader<T>& stateReader,
+                       JsonCapacity& capacity) {
+  DynamicJsonDocument jsonDocument = capacity.fill([&](JsonDocument& document) {
+    JsonObject jsonObject = document.to<JsonObject>();
+    statefulService->read(jsonObject, stateReader);
+  });
+  AsyncResponseStream* response = request->beginResponseStream(JSON_MIMETYPE);
+  serializeJson(jsonDocument, *response);
+  request->send(response);
+}
+
 template <class T>
 class HttpGetEndpoint {
  public:
@@ -21,7 +38,9 @@ class HttpGetEndpoint {
                   SecurityManager* securityManager,
                   AuthenticationPredicate authenticationPredicate = AuthenticationPredicates::IS_ADMIN,
                   size_t bufferSize = DEFAULT_BUFFER_SIZE) :
-      _stateReader(stateReader), _statefulService(statefulService), _bufferSize(bufferSize) {
+      _stateReader(stateReader),
+      _statefulService(statefulService),
+      _capacity("GET " + servicePath, bufferSize) {
     server->on(servicePath.c_str(),
                HTTP_GET,
                securityManager->wrapRequest(std::bind(&HttpGetEndpoint::fetchSettings, this, std::placeholders::_1),
@@ -33,22 +52,23 @@ class HttpGetEndpoint {
                   AsyncWebServer* server,
                   const String& servicePath,
                   size_t bufferSize = DEFAULT_BUFFER_SIZE) :
-      _stateReader(stateReader), _statefulService(statefulService), _bufferSize(bufferSize) {
+      _stateReader(stateReader),
+      _statefulService(statefulService),
+      _capacity("GET " + servicePath, bufferSize) {
     server->on(servicePath.c_str(), HTTP_GET, std::bind(&HttpGetEndpoint::fetchSettings, this, std::placeholders::_1));
   }
 
  protected:
   JsonStateReader<T> _stateReader;
   StatefulService<T>* _statefulService;
-  size_t _bufferSize;
+  JsonCapacity _capacity;
 
+  // ?form=status renders only that form and ?fields=a,b only those fields, for readers built with FormBuilder
   void fetchSettings(AsyncWebServerRequest* request) {
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, _bufferSize);
-    JsonObject jsonObject = response->getRoot().to<JsonObject>();
-    _statefulService->read(jsonObject, _stateReader);
-
-    response->setLength();
-    request->send(response);
+    String forms = request->arg("form");
+    String fields = request->arg("fields");
+    FormFilter filter(forms, fields);
+    sendStateResponse(request, _statefulService, _stateReader, _capacity);
   }
 };
 
@@ -72,7 +92,7 @@ class HttpPostEndpoint {
               std::bind(&HttpPostEndpoint::updateSettings, this, std::placeholders::_1, std::placeholders::_2),
               authenticationPredicate),
           bufferSize),
-      _bufferSize(bufferSize) {
+      _capacity("POST " + servicePath, bufferSize) {
     _updateHandler.setMethod(HTTP_POST);
     server->addHandler(&_updateHandler);
   }
@@ -89,7 +109,7 @@ class HttpPostEndpoint {
       _updateHandler(servicePath,
                      std::bind(&HttpPostEndpoint::updateSettings, this, std::placeholders::_1, std::placeholders::_2),
                      bufferSize),
-      _bufferSize(bufferSize) {
+      _capacity("POST " + servicePath, bufferSize) {
     _updateHandler.setMethod(HTTP_POST);
     server->addHandler(&_updateHandler);
   }
@@ -99,7 +119,7 @@ class HttpPostEndpoint {
   JsonStateUpdater<T> _stateUpdater;
   StatefulService<T>* _statefulService;
   AsyncCallbackJsonWebHandler _updateHandler;
-  size_t _bufferSize;
+  JsonCapacity _capacity;
 
   void updateSettings(AsyncWebServerRequest* request, JsonVariant& json) {
     if (!json.is<JsonObject>()) {
@@ -115,11 +135,7 @@ class HttpPostEndpoint {
     if (outcome == StateUpdateResult::CHANGED) {
       request->onDisconnect([this]() { _statefulService->callUpdateHandlers(HTTP_ENDPOINT_ORIGIN_ID); });
     }
-    AsyncJsonResponse* response = new AsyncJsonResponse(false, _bufferSize);
-    jsonObject = response->getRoot().to<JsonObject>();
-    _statefulService->read(jsonObject, _stateReader);
-    response->setLength();
-    request->send(response);
+    sendStateResponse(request, _statefulService, _stateReader, _capacity);
   }
 };
 
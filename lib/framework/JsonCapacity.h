@@ -0,0 +1,206 @@
+#ifndef JsonCapacity_h
+#define JsonCapacity_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <atomic>
+#include <list>
+
+// Room added on top of the largest document seen, so a slightly longer string does not cost a second attempt
+#ifndef JSON_CAPACITY_HEADROOM_PERCENT
+#define JSON_CAPACITY_HEADROOM_PERCENT 25
+#endif
+
+#ifndef JSON_CAPACITY_MIN_SIZE
+#define JSON_CAPACITY_MIN_SIZE 128
+#endif
+
+/**
+ * What is known about the documents of one consumer whose outbound and inbound sides are separate JsonCapacity
+ * instances, e.g. the pub and sub topics of an MqttPubSub: the largest document seen and, when enabled, a filter with
+ * the top level keys of its own outbound document.
+ *
+ * Owned by the consumer, never shared between consumers that use different readers. The two sides may run in
+ * different tasks, so the fields are atomic and the filter is installed once and never replaced.
+ */
+struct JsonConsumerProfile {
+  std::atomic<size_t> highWater{0};
+  std::atomic<bool> filterInbound{false};
+  std::atomic<DynamicJsonDocument*> filter{nullptr};
+
+  JsonConsumerProfile() = default;
+  JsonConsumerProfile(const JsonConsumerProfile&) = delete;
+  JsonConsumerProfile& operator=(const JsonConsumerProfile&) = delete;
+  ~JsonConsumerProfile() {
+    delete filter.load();
+  }
+};
+
+/**
+ * Capacity policy for the documents of one consumer (an HTTP endpoint, a persisted file, an MQTT topic, a WebSocket).
+ *
+ * The configured buffer size is only the ceiling. The first document is allocated at the ceiling, later ones at the
+ * high-water mark of the consumer (or of its JsonConsumerProfile) plus JSON_CAPACITY_HEADROOM_PERCENT. A document that overflowed
+ * the estimate is built again at the ceiling. Every instance is listed by report().
+ */
+class JsonCapacity {
+ public:
+  JsonCapacity(const String& name, size_t maxCapacity, JsonConsumerProfile* profile = nullptr) :
+      _name(name), _maxCapacity(maxCapacity), _profile(profile), _peak(0), _overflows(0) {
+    registry().push_back(this);
+  }
+
+  ~JsonCapacity() {
+    registry().remove(this);
+  }
+
+  JsonCapacity(const JsonCapacity&) = delete;
+  JsonCapacity& operator=(const JsonCapacity&) = delete;
+
+  size_t capacity() const {
+    size_t highWater = _peak;
+    if (_profile) {
+      size_t shared = _profile->highWater.load();
+      if (shared > highWater) {
+        highWater = shared;
+      }
+    }
+    if (!highWater) {
+      return _maxCapacity;
+    }
+    size_t capacity = highWater + highWater * JSON_CAPACITY_HEADROOM_PERCENT / 100;
+    capacity = (capacity + 7) & ~(size_t)7;
+    if (capacity < JSON_CAPACITY_MIN_SIZE) {
+      capacity = JSON_CAPACITY_MIN_SIZE;
+    }
+    return capacity < _maxCapacity ? capacity : _maxCapacity;
+  }
+
+  // records the memory a finished document used, returns false if it overflowed
+  bool record(const JsonDocument& document) {
+    if (document.overflowed()) {
+      _overflows++;
+      return false;
+    }
+    size_t used = document.memoryUsage();
+    if (used > _peak) {
+      _peak = used;
+    }
+    if (_profile) {
+      size_t shared = _profile->highWater.load();
+      while (used > shared && !_profile->highWater.compare_exchange_weak(shared, used)) {
+      }
+    }
+    return true;
+  }
+
+  // builds an outbound document with fill(JsonDocument&)
+  template <typename Fill>
+  DynamicJsonDocument fill(Fill fill) {
+    DynamicJsonDocument document(capacity());
+    fill(document);
+    if (!record(document) && document.capacity() < _maxCapacity) {
+      document = DynamicJsonDocument(_maxCapacity);
+      fill(document);
+      record(document);
+    }
+    if (_profile && _profile->filterInbound && !_profile->filter.load() && !document.overflowed()) {
+      learnFilter(document.as<JsonObject>());
+    }
+    return document;
+  }
+
+  // parses an inbound document with parse(JsonDocument&), which must restart from the beginning of its input
+  template <typename Parse>
+  DynamicJsonDocument parse(Parse parse, DeserializationError* error) {
+    DynamicJsonDocument document(capacity());
+    *error = parse(document);
+    if (*error == DeserializationError::NoMemory && document.capacity() < _maxCapacity) {
+      _overflows++;
+      document = DynamicJsonDocument(_maxCapacity);
+      *error = parse(document);
+    }
+    if (*error == DeserializationError::Ok) {
+      record(document);
+    }
+    return document;
+  }
+
+  // filter with the keys of the consumer's outbound document, null until learned or when not enabled
+  const JsonDocument* inboundFilter() const {
+    return _profile && _profile->filterInbound ? _profile->filter.load() : nullptr;
+  }
+
+  // drops unknown top level keys of inbound updates of the profile, learned from its next outbound document
+  void enableInboundFilter() {
+    if (_profile) {
+      _profile->filterInbound = true;
+    }
+  }
+
+  const String& name() const {
+    return _name;
+  }
+  void setName(const String& name) {
+    _name = name;
+  }
+  size_t maxCapacity() const {
+    return _maxCapacity;
+  }
+  size_t peak() const {
+    return _peak;
+  }
+  uint32_t overflows() const {
+    return _overflows;
+  }
+
+  // adds one object per consumer: name, peak, capacity, max and overflows
+  static void report(JsonArray& entries) {
+    for (JsonCapacity* capacity : registry()) {
+      JsonObject entry = entries.createNestedObject();
+      entry["name"] = capacity->_name;
+      entry["peak"] = capacity->_peak;
+      entry["capacity"] = capacity->capacity();
+      entry["max"] = capacity->_maxCapacity;
+      entry["overflows"] = capacity->_overflows;
+    }
+  }
+
+  static size_t count() {
+    return registry().size();
+  }
+
+ private:
+  String _name;
+  size_t _maxCapacity;
+  JsonConsumerProfile* _profile;
+  size_t _peak;
+  uint32_t _overflows;
+
+  static std::list<JsonCapacity*>& registry() {
+    static std::list<JsonCapacity*> capacities;
+    return capacities;
+  }
+
+  void learnFilter(JsonObject root) {
+    if (root.isNull()) {
+      return;
+    }
+    size_t size = JSON_OBJECT_SIZE(root.size());
+    for (JsonPair pair : root) {
+      size += strlen(pair.key().c_str()) + 1;
+    }
+    DynamicJsonDocument* filter = new DynamicJsonDocument(size);
+    for (JsonPair pair : root) {
+      (*filter)[String(pair.key().c_str())] = true;
+    }
+    // the other side may be reading the installed filter, so a second one learned concurrently is dropped
+    DynamicJsonDocument* none = nullptr;
+    if (!_profile->filter.compare_exchange_strong(none, filter)) {
+      delete filter;
+    }
+  }
+};
+
+#endif  // end JsonCapacity_h
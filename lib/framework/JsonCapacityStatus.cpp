@@ -0,0 +1,21 @@
+#include <JsonCapacityStatus.h>
+
+JsonCapacityStatus::JsonCapacityStatus(AsyncWebServer* server, SecurityManager* securityManager) {
+  server->on(JSON_CAPACITY_STATUS_SERVICE_PATH,
+             HTTP_GET,
+             securityManager->wrapRequest(
+                 std::bind(&JsonCapacityStatus::jsonCapacityStatus, this, std::placeholders::_1),
+                 AuthenticationPredicates::IS_AUTHENTICATED));
+}
+
+void JsonCapacityStatus::jsonCapacityStatus(AsyncWebServerRequest* request) {
+  // names are copied into the document, 48 bytes each is plenty for a path or topic
+  size_t entries = JsonCapacity::count();
+  AsyncJsonResponse* response =
+      new AsyncJsonResponse(false, JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(entries) + entries * (JSON_OBJECT_SIZE(5) + 48));
+  JsonObject root = response->getRoot();
+  JsonArray documents = root.createNestedArray("documents");
+  JsonCapacity::report(documents);
+  response->setLength();
+  request->send(response);
+}
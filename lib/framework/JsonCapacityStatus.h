@@ -0,0 +1,23 @@
+#ifndef JsonCapacityStatus_h
+#define JsonCapacityStatus_h
+
+#include <ArduinoJson.h>
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+#include <JsonCapacity.h>
+#include <SecurityManager.h>
+
+#define JSON_CAPACITY_STATUS_SERVICE_PATH "/rest/jsonCapacity"
+
+/**
+ * Reports the peak document size of every endpoint, persisted file and topic, see JsonCapacity.
+ */
+class JsonCapacityStatus {
+ public:
+  JsonCapacityStatus(AsyncWebServer* server, SecurityManager* securityManager);
+
+ private:
+  void jsonCapacityStatus(AsyncWebServerRequest* request);
+};
+
+#endif  // end JsonCapacityStatus_h
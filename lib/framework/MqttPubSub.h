@@ -2,6 +2,7 @@
 #define MqttPubSub_h
 
 #include <StatefulService.h>
+#include <JsonCapacity.h>
 #include <AsyncMqttClient.h>
 
 #define MQTT_ORIGIN_ID "mqtt"
@@ -12,6 +13,8 @@ class MqttConnector {
   StatefulService<T>* _statefulService;
   AsyncMqttClient* _mqttClient;
   size_t _bufferSize;
+  // shared by the pub and sub topics of one MqttPubSub, which use the same reader
+  JsonConsumerProfile _profile;
 
   MqttConnector(StatefulService<T>* statefulService, AsyncMqttClient* mqttClient, size_t bufferSize) :
       _statefulService(statefulService), _mqttClient(mqttClient), _bufferSize(bufferSize) {
@@ -38,8 +41,26 @@ class MqttPub : virtual public MqttConnector<T> {
       MqttConnector<T>(statefulService, mqttClient, bufferSize),
       _stateReader(stateReader),
       _pubTopic(pubTopic),
-      _retain(retain) {
-    MqttConnector<T>::_statefulService->addUpdateHandler([&](const String& originId) { publish(); }, false);
+      _retain(retain),
+      _publishedFields(STATE_CHANGE_ALL),
+      _capacity("MQTT " + pubTopic, bufferSize, &this->_profile) {
+    MqttConnector<T>::_statefulService->addChangeHandler(
+        [&](const String& originId, state_change_mask_t changed) {
+          if (changed & _publishedFields) {
+            publish();
+          }
+        },
+        false);
+  }
+
+  // Drops unknown keys of messages on the sub topic, see JsonCapacity::enableInboundFilter()
+  void enableInboundFilter() {
+    _capacity.enableInboundFilter();
+  }
+
+  // Changes that touch none of these fields are not published
+  void setPublishedFields(state_change_mask_t fields) {
+    _publishedFields = fields;
   }
 
   void setRetain(const bool retain) {
@@ -49,6 +70,7 @@ class MqttPub : virtual public MqttConnector<T> {
 
   void setPubTopic(const String& pubTopic) {
     _pubTopic = pubTopic;
+    _capacity.setName("MQTT " + pubTopic);
     publish();
   }
 
@@ -61,13 +83,16 @@ class MqttPub : virtual public MqttConnector<T> {
   JsonStateReader<T> _stateReader;
   String _pubTopic;
   bool _retain;
+  state_change_mask_t _publishedFields;
+  JsonCapacity _capacity;
 
   void publish() {
     if (_pubTopic.length() > 0 && MqttConnector<T>::_mqttClient->connected()) {
       // serialize to json doc
-      DynamicJsonDocument json(MqttConnector<T>::_bufferSize);
-      JsonObject jsonObject = json.to<JsonObject>();
-      MqttConnector<T>::_statefulService->read(jsonObject, _stateReader);
+      DynamicJsonDocument json = _capacity.fill([&](JsonDocument& document) {
+        JsonObject jsonObject = document.to<JsonObject>();
+        MqttConnector<T>::_statefulService->read(jsonObject, _stateReader);
+      });
 
       // serialize to string
       String payload;
@@ -87,7 +112,10 @@ class MqttSub : virtual public MqttConnector<T> {
           AsyncMqttClient* mqttClient,
           const String& subTopic = "",
           size_t bufferSize = DEFAULT_BUFFER_SIZE) :
-      MqttConnector<T>(statefulService, mqttClient, bufferSize), _stateUpdater(stateUpdater), _subTopic(subTopic) {
+      MqttConnector<T>(statefulService, mqttClient, bufferSize),
+      _stateUpdater(stateUpdater),
+      _subTopic(subTopic),
+      _capacity("MQTT " + subTopic, bufferSize, &this->_profile) {
     MqttConnector<T>::_mqttClient->onMessage(std::bind(&MqttSub::onMqttMessage,
                                                        this,
                                                        std::placeholders::_1,
@@ -106,6 +134,7 @@ class MqttSub : virtual public MqttConnector<T> {
       }
       // set the new topic and re-configure the subscription
       _subTopic = subTopic;
+      _capacity.setName("MQTT " + subTopic);
       subscribe();
     }
   }
@@ -118,6 +147,7 @@ class MqttSub : virtual public MqttConnector<T> {
  private:
   JsonStateUpdater<T> _stateUpdater;
   String _subTopic;
+  JsonCapacity _capacity;
 
   void subscribe() {
     if (_subTopic.length() > 0) {
@@ -136,9 +166,15 @@ class MqttSub : virtual public MqttConnector<T> {
       return;
     }
 
-    // deserialize from string
-    DynamicJsonDocument json(MqttConnector<T>::_bufferSize);
-    DeserializationError error = deserializeJson(json, payload, len);
+    // deserialize from string, dropping keys the pub topic does not carry when the inbound filter is enabled
+    const JsonDocument* filter = _capacity.inboundFilter();
+    DeserializationError error;
+    DynamicJsonDocument json = _capacity.parse(
+        [&](JsonDocument& document) {
+          return filter ? deserializeJson(document, payload, len, DeserializationOption::Filter(*filter))
+                        : deserializeJson(document, payload, len);
+        },
+        &error);
     if (!error && json.is<JsonObject>()) {
       JsonObject jsonObject = json.as<JsonObject>();
       MqttConnector<T>::_statefulService->update(jsonObject, _stateUpdater, MQTT_ORIGIN_ID);
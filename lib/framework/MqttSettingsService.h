@@ -67,7 +67,7 @@ class MqttSettings {
   bool cleanSession;
   uint16_t maxTopicLength;
 
-  static void read(MqttSettings& settings, JsonObject& root) {
+  static void read(const MqttSettings& settings, JsonObject& root) {
     root["enabled"] = settings.enabled;
     root["host"] = settings.host;
     root["port"] = settings.port;
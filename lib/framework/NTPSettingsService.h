@@ -40,7 +40,7 @@ class NTPSettings {
   String tzFormat;
   String server;
 
-  static void read(NTPSettings& settings, JsonObject& root) {
+  static void read(const NTPSettings& settings, JsonObject& root) {
     root["enabled"] = settings.enabled;
     root["server"] = settings.server;
     root["tz_label"] = settings.tzLabel;
@@ -5,22 +5,186 @@
 #include <Ticker.h>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <deque>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include "StatefulService.h"
+#include "JsonCapacity.h"
+#include "WsTokenBucket.h"
+#include "WsReassembler.h"
+
+/* стеля розміру документа одного повідомлення; фактичний розмір — за JsonCapacity */
+#ifndef WS_MAX_DOCUMENT_SIZE
+#define WS_MAX_DOCUMENT_SIZE 2048
+#endif
+
+/* origin_id повного кадру, що віддається з кешу (підключення, resync, пропущені кадри) */
+#define WS_SNAPSHOT_ORIGIN "snapshot"
+
+/* dispatch-задача (beginDispatchTask): єдиний споживач черг, подій клієнтів і розсилок */
+#ifndef WS_DISPATCH_TASK_PRIORITY
+#define WS_DISPATCH_TASK_PRIORITY 2
+#endif
+#ifndef WS_DISPATCH_TASK_CORE
+#define WS_DISPATCH_TASK_CORE tskNO_AFFINITY
+#endif
+#ifndef WS_DISPATCH_TASK_STACK_SIZE
+#define WS_DISPATCH_TASK_STACK_SIZE 6144
+#endif
+/* як часто задача перевіряє відкладене (ліміт, інтервали, backlog), поки воно є; інакше спить до події */
+#ifndef WS_DISPATCH_RETRY_MS
+#define WS_DISPATCH_RETRY_MS 10
+#endif
+
+/* інтервал кадрів стану для клієнта: від 10 Гц у LAN до 1 Гц на слабкому лінку,
+ * = RTT * WS_CLIENT_RTT_FACTOR + глибина TCP-черги * WS_CLIENT_QUEUE_STEP_MS */
+#ifndef WS_CLIENT_MIN_INTERVAL_MS
+#define WS_CLIENT_MIN_INTERVAL_MS 100
+#endif
+#ifndef WS_CLIENT_MAX_INTERVAL_MS
+#define WS_CLIENT_MAX_INTERVAL_MS 1000
+#endif
+#ifndef WS_CLIENT_RTT_FACTOR
+#define WS_CLIENT_RTT_FACTOR 4
+#endif
+#ifndef WS_CLIENT_QUEUE_STEP_MS
+#define WS_CLIENT_QUEUE_STEP_MS 150
+#endif
+
+/* скільки впорядкованих (не-станових) повідомлень чекає на повільного клієнта; стан займає один прапорець */
+#ifndef WS_MAX_ORDERED_MESSAGES
+#define WS_MAX_ORDERED_MESSAGES 8
+#endif
+
+/* ---- дескриптор endpoint-у: індекс у MultiWsManager, видається addEndpoint() ---- */
+typedef uint8_t ws_endpoint_t;
+#define WS_INVALID_ENDPOINT ((ws_endpoint_t)0xFF)
+
+/* FNV-1a шляху — пошук endpoint-у за path порівнює числа, а не String */
+inline uint32_t wsPathHash(const char* s){
+    uint32_t h=2166136261u;
+    while(*s){ h^=(uint8_t)*s++; h*=16777619u; }
+    return h;
+}
+
+/* ---- відкладене для клієнта, якому TCP-черга не дає відправити ----
+ * ordered — повідомлення, які не можна пропустити (id, enqueue/sendTo), у порядку надходження;
+ * stale — кадр стану пропущено: коли клієнт звільниться, отримає свіжий повний стан замість усіх проміжних */
+struct WsClientBacklog{ std::deque<std::pair<AsyncWebSocketSharedBuffer,bool>> ordered; bool stale=false; };
+
+/* ---- стан з'єднання одного клієнта ---- */
+struct WsClientStats{
+    unsigned long lastPong=0;
+    float         rtt=0.f;                     // EWMA, мс
+    bool          hasRtt=false;
+    uint32_t      intervalMs=WS_CLIENT_MIN_INTERVAL_MS;
+    unsigned long lastState=0;                 // коли пішов останній кадр стану
+    uint32_t      frames=0;
+    uint32_t      coalesced=0;                 // кадри стану, замінені свіжішим
+};
+
+/* ---- копія WsClientStats для /rest/wsClients, яку dispatch оновлює наприкінці кожного проходу ---- */
+struct WsClientStatsEntry{
+    const char* endpoint;                      // WsEndpointDesc::path, живе разом з менеджером
+    uint32_t    id;
+    float       rtt;
+    bool        hasRtt;
+    size_t      queue;
+    uint32_t    intervalMs,frames,coalesced;
+    size_t      backlog;
+};
+
+/* ---- ключ payload-у → біт поля стану (для часткових розсилок) ---- */
+struct WsFieldKey{ const char* key; state_change_mask_t field; };
 
 /* ---------- опис endpoint-у ---------- */
 struct WsEndpointDesc{
     String              path;
+    uint32_t            pathHash;
+    ws_endpoint_t       id;
     void*               stateService;          //  StatefulService<TState>*
     std::function<void(void*,JsonObject&)>     readFn;
-    std::function<StateUpdateResult(JsonObject&,void*)> updateFn;
+    std::function<StateUpdateResult(JsonObject&,void*,const String&)> updateFn;
+    std::function<uint32_t(void*)>             revisionFn;
     AsyncWebSocket*     ws;
+    std::vector<WsFieldKey> fieldKeys;         // порожньо → завжди повний стан
+    JsonCapacity*       capacity;              // розмір документів Tx / Rx цього endpoint-у
+    bool                delta=false;           // розсилати {"type":"d"} замість повного стану
+    DynamicJsonDocument* last=nullptr;         // стан, який уже мають клієнти (для delta)
+    uint32_t            lastRev=0;             // ревізія, з якої зібраний last
+    state_change_mask_t lastStale=0;           // змінені поля, яких ніхто не отримав, — у last їх ще нема
+    std::map<String,std::vector<String>> formKeys;      // форма → ключі payload-у, які вона показує
+    std::map<uint32_t,std::vector<String>> subs;        // cid → підписані ключі; нема запису → усі ключі
+    std::map<uint32_t,WsClientBacklog>     backlog;     // cid → відкладене для повільних клієнтів
+    std::map<uint32_t,WsClientStats>       clients;     // cid → RTT, інтервал, лічильники (id унікальні лише в межах endpoint-у)
+    WsTokenBucket       bucket;                // ліміт розсилок стану (за замовчуванням вимкнено)
+    state_change_mask_t pendingMask=0;         // зміни, що чекають на токен
+    String              pendingOrigin;
+    state_change_mask_t requestedMask=0;       // broadcastCurrentState з інших задач, чекає на dispatch (під _reqLock)
+    String              requestedOrigin;
+    WsReassembler*      rx=nullptr;            // фрагментовані повідомлення клієнтів (лише в задачі AsyncTCP)
+    uint32_t            echoCid=0;             // автор зміни, чия розсилка ще не пішла
+    DynamicJsonDocument* echo=nullptr;         // що саме він надіслав — ці значення в нього вже є
+    AsyncWebSocketSharedBuffer snapshot;       // останній повний кадр для нових клієнтів і resync
+    uint32_t            snapshotRev=0;         // ревізія стану, з якої він зібраний
+    uint32_t            stateGen=0;            // +1 на кожну розсилку стану та зміну last: ревізія не ловить
+    uint32_t            snapshotGen=0;         //   змін полів, що оминають update() (напр. лише callUpdateHandlers)
+};
+
+/* ---- JSON merge patch (RFC 7396) між двома знімками стану ----
+ * масиви та значення замінюються цілком, вкладені об'єкти порівнюються рекурсивно */
+struct WsMergePatch{
+    /* ключі cur, що відрізняються від prev; removals — ключі prev, яких нема в cur, стають null */
+    static void diff(JsonObjectConst prev,JsonObjectConst cur,JsonObject patch,bool removals){
+        for(JsonPairConst kv:cur){
+            JsonVariantConst old=prev[kv.key()];
+            if(old.is<JsonObjectConst>() && kv.value().is<JsonObjectConst>()){
+                JsonObject nested=patch.createNestedObject(kv.key());
+                diff(old.as<JsonObjectConst>(),kv.value().as<JsonObjectConst>(),nested,true);
+                if(nested.size()==0) patch.remove(kv.key());
+            }else if(!prev.containsKey(kv.key()) || old!=kv.value()){
+                patch[kv.key()]=kv.value();
+            }
+        }
+        if(removals)
+            for(JsonPairConst kv:prev) if(!cur.containsKey(kv.key())) patch[kv.key()]=nullptr;
+    }
+    static void apply(JsonObject target,JsonObjectConst patch){
+        for(JsonPairConst kv:patch){
+            if(kv.value().isNull()){ target.remove(kv.key()); continue; }
+            if(kv.value().is<JsonObjectConst>()){
+                JsonObject t=target[kv.key()].is<JsonObject>() ? target[kv.key()].as<JsonObject>()
+                                                               : target.createNestedObject(kv.key());
+                apply(t,kv.value().as<JsonObjectConst>());
+            }else target[kv.key()]=kv.value();
+        }
+    }
 };
 
-/* ---- елементи черг Tx / Rx ---- */
-struct WsQueueItem   { String path; uint32_t cid; String payload; bool text; };
-struct WsIncomingItem{ String path; uint32_t cid; String payload; bool text; };
+/* ---- елементи черг Tx / Rx ----
+ * Tx тримає вже серіалізований буфер; textAll / text лише посилаються на нього, тож усі адресати ділять одну копію.
+ * cids порожній → усі клієнти endpoint-а; state — кадр стану, який новіший кадр робить непотрібним */
+struct WsQueueItem   { ws_endpoint_t ep; std::vector<uint32_t> cids; AsyncWebSocketSharedBuffer buf; bool text; bool state; };
+/* Rx: дані (_rxQ) і події з'єднань (_control) — їх обробляє той самий споживач, що й Tx */
+enum WsIncomingKind : uint8_t { WS_IN_DATA, WS_IN_CONNECT, WS_IN_DISCONNECT, WS_IN_PONG };
+struct WsIncomingItem{ ws_endpoint_t ep; uint32_t cid; WsIncomingKind kind; unsigned long at; String payload; bool text; };
+
+/* ---- Print прямо в буфер повідомлення (без проміжного String) ---- */
+class WsBufferPrint : public Print{
+public:
+    WsBufferPrint(uint8_t* dst,size_t cap):_dst(dst),_left(cap){}
+    size_t write(uint8_t c) override { return write(&c,1); }
+    size_t write(const uint8_t* b,size_t n) override {
+        if(n>_left) n=_left;
+        memcpy(_dst,b,n); _dst+=n; _left-=n;
+        return n;
+    }
+private:
+    uint8_t* _dst; size_t _left;
+};
 
 /* ========================================================= */
 class MultiWsManager{
@@ -30,78 +194,163 @@ public:
         _pingIntervalSec(10),
         _pongTimeoutMs(30000),
         _lastPingTs(0),
-        _hasFirstRtt(false),
-        _alpha(0.3f),
-        _avgRtt(0.f)
+        _alpha(0.3f)
     {
         _txQ = xQueueCreate(qSize,sizeof(WsQueueItem*));
         _rxQ = xQueueCreate(qSize,sizeof(WsIncomingItem*));
+        _lock    = xSemaphoreCreateRecursiveMutex();
+        _reqLock = xSemaphoreCreateMutex();
         configASSERT(_txQ);  configASSERT(_rxQ);
     }
     ~MultiWsManager(){
         _pingTicker.detach();
-        if(_txQ) vQueueDelete(_txQ);
-        if(_rxQ) vQueueDelete(_rxQ);
-        for(auto &d:_dsc) delete d.ws;
+        if(_task) vTaskDelete(_task);
+        if(_txQ){
+            WsQueueItem* it=nullptr;
+            while(xQueueReceive(_txQ,&it,0)==pdTRUE) delete it;
+            vQueueDelete(_txQ);
+        }
+        if(_rxQ){
+            WsIncomingItem* it=nullptr;
+            while(xQueueReceive(_rxQ,&it,0)==pdTRUE) delete it;
+            vQueueDelete(_rxQ);
+        }
+        for(auto &d:_dsc){ delete d.ws; delete d.capacity; delete d.last; delete d.rx; delete d.echo; }
+        vSemaphoreDelete(_lock); vSemaphoreDelete(_reqLock);
     }
 
-    /* ---------- реєстрація endpoint-у ---------- */
+    /* ---------- реєстрація endpoint-у ----------
+     * повертає дескриптор для гарячих викликів (broadcastCurrentState, enqueue), WS_INVALID_ENDPOINT — якщо місць нема */
     template<typename TState>
-    void addEndpoint(const String& path,
-                     StatefulService<TState>* svc,
-                     std::function<void(TState&,JsonObject&)>      read,
-                     std::function<StateUpdateResult(JsonObject&,TState&)> upd)
+    ws_endpoint_t addEndpoint(const String& path,
+                              StatefulService<TState>* svc,
+                              std::function<void(const TState&,JsonObject&)> read,
+                              std::function<StateUpdateResult(JsonObject&,TState&)> upd)
     {
+        if(_dsc.size()>=WS_INVALID_ENDPOINT) return WS_INVALID_ENDPOINT;
+        ws_endpoint_t id=(ws_endpoint_t)_dsc.size();
         AsyncWebSocket* ws = new AsyncWebSocket(path.c_str());
-        ws->onEvent([this,path](AsyncWebSocket* s,AsyncWebSocketClient* c,
-                                AwsEventType t,void* a,uint8_t* d,size_t l)
+        ws->onEvent([this,id](AsyncWebSocket*,AsyncWebSocketClient* c,
+                              AwsEventType t,void* a,uint8_t* d,size_t l)
         {
-            for(auto &e:_dsc) if(e.path==path && e.ws==s){
-                this->handleWsEvent(e,c,t,a,d,l);   // <–– прототип нижче
-                return;
-            }
+            this->handleWsEvent(_dsc[id],c,t,a,d,l);
         });
         _server->addHandler(ws);
 
         WsEndpointDesc e;
-        e.path=path;  e.ws=ws;
+        e.path=path;  e.pathHash=wsPathHash(path.c_str());  e.id=id;  e.ws=ws;
+        e.capacity=new JsonCapacity("WS "+path,WS_MAX_DOCUMENT_SIZE);
+        e.rx=new WsReassembler(WS_MAX_DOCUMENT_SIZE);    // довше однаково не розбереться в документ
         e.stateService=static_cast<void*>(svc);
-        e.readFn=[read](void* p,JsonObject& root){
-            read(*static_cast<TState*>(p),root);
+        // через сервіс: блокування / snapshot-читання як у HTTP та MQTT
+        e.readFn=[svc,read](void*,JsonObject& root){
+            svc->read(root,read);
         };
-        e.updateFn=[upd](JsonObject& j,void* p){
-            return upd(j,*static_cast<TState*>(p));
+        e.updateFn=[svc,upd](JsonObject& j,void*,const String& origin){
+            return svc->update(j,upd,origin);
         };
+        e.revisionFn=[svc](void*){ return svc->revision(); };
         _dsc.push_back(e);
+        return id;
+    }
+
+    ws_endpoint_t endpoint(const String& path){
+        WsEndpointDesc* d=find(path);
+        return d ? d->id : WS_INVALID_ENDPOINT;
     }
 
     /* ==================== API ===================== */
+    void enqueue(ws_endpoint_t ep,uint32_t cid,const String& pl,bool txt){
+        WsEndpointDesc* d=desc(ep);
+        if(!d) return;
+        auto buf=std::make_shared<std::vector<uint8_t>>((const uint8_t*)pl.c_str(),(const uint8_t*)pl.c_str()+pl.length());
+        enqueueBuffer(*d,cids(cid),buf,txt);
+    }
+    /* документ серіалізується один раз, прямо в буфер, який потім ділять усі клієнти */
+    void enqueue(ws_endpoint_t ep,uint32_t cid,const JsonDocument& doc,bool txt){
+        WsEndpointDesc* d=desc(ep);
+        if(d) enqueueDoc(*d,cids(cid),doc,txt);
+    }
     void enqueue(const String& path,uint32_t cid,const String& pl,bool txt){
-        auto* it=new WsQueueItem{path,cid,pl,txt};
-        if(xQueueSend(_txQ,&it,0)!=pdTRUE) delete it;
+        enqueue(endpoint(path),cid,pl,txt);
+    }
+    void enqueue(const String& path,uint32_t cid,const JsonDocument& doc,bool txt){
+        enqueue(endpoint(path),cid,doc,txt);
     }
     void broadcast(const String& path,const String& pl,bool txt=true){
         enqueue(path,0,pl,txt);
     }
+    void broadcast(const String& path,const JsonDocument& doc,bool txt=true){
+        enqueue(path,0,doc,txt);
+    }
     void sendTo(const String& path,uint32_t cid,const String& pl,bool txt=true){
         enqueue(path,cid,pl,txt);
     }
+    void sendTo(const String& path,uint32_t cid,const JsonDocument& doc,bool txt=true){
+        enqueue(path,cid,doc,txt);
+    }
 
-    /* --- push актуального стану всім клієнтам endpoint-а --- */
-    void broadcastCurrentState(const String& path,const String& origin=""){
-        StaticJsonDocument<2048> doc;
-        JsonObject root=doc.to<JsonObject>();
-        root["type"]="p"; root["origin_id"]=origin;
-        JsonObject p=root.createNestedObject("p");
+    /* --- які ключі payload-у залежать від яких бітів стану --- */
+    void setFieldKeys(const String& path,const std::vector<WsFieldKey>& keys){
+        if(WsEndpointDesc* d=find(path)) d->fieldKeys=keys;
+    }
+
+    /* --- ключі payload-у, які показує форма; клієнт підписується на форму як на список цих ключів ---
+     *     {"type":"sub","forms":["status"],"keys":["led_on"]} — лише ці ключі, {"type":"sub","keys":[]} — нічого,
+     *     {"type":"sub"} — знову всі */
+    void setFormKeys(const String& path,const String& form,const std::vector<String>& keys){
+        if(WsEndpointDesc* d=find(path)) d->formKeys[form]=keys;
+    }
+
+    /* --- delta-режим: клієнти отримують лише змінені ключі ({"type":"d","d":{...}}, JSON merge patch),
+     *     повний стан — при підключенні та на {"type":"resync"}.
+     *     Знімок живе між розсилками, тож readFn не повинен прив'язувати const char* до тимчасових буферів --- */
+    void setDeltaMode(const String& path,bool enabled=true){
+        WsEndpointDesc* d=find(path);
+        if(!d) return;
+        d->delta=enabled;
+        delete d->last; d->last=nullptr; d->lastStale=0;
+        d->stateGen++;
+    }
 
-        for(auto &d:_dsc) if(d.path==path){ d.readFn(d.stateService,p); break; }
+    /* --- ліміт розсилок стану: burst підряд, далі одна на intervalMs; зміни понад ліміт зливаються
+     *     й розсилаються dispatch-ом, щойно з'явиться токен --- */
+    void setRateLimit(const String& path,uint8_t burst,uint32_t intervalMs){
+        if(WsEndpointDesc* d=find(path)) d->bucket.configure(burst,intervalMs);
+    }
 
-        String out; serializeJson(doc,out);
-        broadcast(path,out,true);
+    /* --- push актуального стану всім клієнтам endpoint-а ---
+     * changed — маска змінених полів; ключі з fieldKeys, яких вона не зачіпає, не надсилаються */
+    void broadcastCurrentState(const String& path,const String& origin="",
+                               state_change_mask_t changed=STATE_CHANGE_ALL){
+        broadcastCurrentState(endpoint(path),origin,changed);
+    }
+    void broadcastCurrentState(ws_endpoint_t ep,const String& origin="",
+                               state_change_mask_t changed=STATE_CHANGE_ALL){
+        WsEndpointDesc* d=desc(ep);
+        if(!d) return;
+        if(_task){                                  // читання й серіалізація — у dispatch-задачі, запити зливаються
+            xSemaphoreTake(_reqLock,portMAX_DELAY);
+            mergeOrigin(d->requestedOrigin,d->requestedMask,origin);
+            d->requestedMask|=changed;
+            xSemaphoreGive(_reqLock);
+            xTaskNotifyGive(_task);
+            return;
+        }
+        lock(); renderBroadcast(*d,origin,changed); unlock();
     }
 
+    /* --- з dispatch-задачею лише будить її; без неї обробляє все в контексті виклику --- */
     void processAllQueues(){
-        processRx(); processTx();
+        if(_task){ xTaskNotifyGive(_task); return; }
+        dispatch();
+    }
+
+    /* --- окрема задача, що блокується на notify (черги Tx / Rx, розсилки, ping) і лише вона чіпає стан клієнтів --- */
+    bool beginDispatchTask(UBaseType_t priority=WS_DISPATCH_TASK_PRIORITY,BaseType_t core=WS_DISPATCH_TASK_CORE){
+        if(_task) return true;
+        return xTaskCreatePinnedToCore(dispatchTask,"WsDispatch",WS_DISPATCH_TASK_STACK_SIZE,this,
+                                       priority,&_task,core)==pdPASS;
     }
 
     /* -------- Ping / Pong -------- */
@@ -109,112 +358,606 @@ public:
         _pingIntervalSec=pingS;
         _pingTicker.attach((float)_pingIntervalSec,staticPingCb,this);
     }
-    float averageRTT()const{ return _avgRtt; }
+    /* статистика читається з копії під коротким _reqLock: _lock dispatch тримає всю розсилку,
+     * а ці виклики приходять із задачі AsyncTCP */
+
+    /* середній RTT усіх клієнтів, мс */
+    float averageRTT()const{
+        xSemaphoreTake(_reqLock,portMAX_DELAY);
+        float sum=0.f; size_t n=0;
+        for(auto &c:_stats) if(c.hasRtt){ sum+=c.rtt; n++; }
+        xSemaphoreGive(_reqLock);
+        return n ? sum/n : 0.f;
+    }
+
+    /* по об'єкту на клієнта: endpoint, id, rtt, queue, interval, frames, coalesced, backlog */
+    void clientStats(JsonArray& out){
+        xSemaphoreTake(_reqLock,portMAX_DELAY);
+        for(auto &c:_stats){
+            JsonObject o=out.createNestedObject();
+            o["endpoint"] =c.endpoint;         // рядок живе довше за відповідь
+            o["id"]       =c.id;
+            o["rtt"]      =c.rtt;
+            o["queue"]    =c.queue;
+            o["interval"] =c.intervalMs;
+            o["frames"]   =c.frames;
+            o["coalesced"]=c.coalesced;
+            o["backlog"]  =c.backlog;
+        }
+        xSemaphoreGive(_reqLock);
+    }
+    size_t clientCount()const{
+        xSemaphoreTake(_reqLock,portMAX_DELAY);
+        size_t n=_stats.size();
+        xSemaphoreGive(_reqLock);
+        return n;
+    }
 
 private:
     /* ---- internal ---- */
     AsyncWebServer*              _server;
     std::vector<WsEndpointDesc>  _dsc;
     QueueHandle_t                _txQ{},_rxQ{};
+    SemaphoreHandle_t            _lock{};         // стан endpoint-ів і клієнтів: dispatch vs. статистика
+    SemaphoreHandle_t            _reqLock{};      // requestedMask / requestedOrigin, _control, _stats
+    std::deque<WsIncomingItem>   _control;        // події з'єднань із задачі AsyncTCP, без ліміту черги
+    std::vector<WsClientStatsEntry> _stats;       // копія статистики клієнтів для читачів поза dispatch
+    TaskHandle_t                 _task{};
+    volatile bool                _pingDue=false;
     Ticker                       _pingTicker;
     unsigned                     _pingIntervalSec;
     unsigned long                _pongTimeoutMs,_lastPingTs;
-    std::map<uint32_t,unsigned long> _lastPong;
-    bool                         _hasFirstRtt;
-    float                        _alpha,_avgRtt;
+    float                        _alpha;          // вага нового вимірювання RTT
+
+    /* розсилка в контексті dispatch: зміна полів, на які ніхто не підписаний, не читається й не серіалізується */
+    void renderBroadcast(WsEndpointDesc& d,const String& origin,state_change_mask_t changed){
+        d.stateGen++;                               // стан змінився, навіть якщо розсилка нижче не піде
+        if(changed!=STATE_CHANGE_ALL && !(changed & subscribedFields(d))){
+            if(d.last) d.lastStale|=changed;        // last відстав — дочитається, щойно його комусь віддаватимуть
+            return;
+        }
+        if(!d.bucket.tryAcquire(millis())){
+            mergeOrigin(d.pendingOrigin,d.pendingMask,origin);
+            d.pendingMask|=changed;
+            return;
+        }
+        String from=origin;
+        mergeOrigin(from,d.pendingMask,d.pendingOrigin);
+        changed|=d.pendingMask; d.pendingMask=0;
+        uint32_t author=echoAuthor(d,from);
+        if(d.delta && d.last) broadcastDelta(d,from,changed,author);
+        else                  sendState(d,0,from,d.delta ? STATE_CHANGE_ALL : changed,author);
+        dropEcho(d);
+    }
+
+    /* злиті зміни різних авторів — спільного автора нема, луна не придушується */
+    static void mergeOrigin(String& into,state_change_mask_t had,const String& origin){
+        if(!had || into==origin) into=origin;
+        else                     into=String();
+    }
+
+    /* ---- придушення луни: автор зміни не отримує назад власні значення ---- */
+    uint32_t echoAuthor(WsEndpointDesc& d,const String& origin){
+        return d.echo && origin==wsOrigin(d.echoCid) ? d.echoCid : 0;
+    }
+    static String wsOrigin(uint32_t cid){ return "ws:"+String(cid); }
+
+    /* надіслане клієнтом до розсилки; повторні правки того ж клієнта зливаються */
+    void noteEcho(WsEndpointDesc& d,uint32_t cid,JsonObject p){
+        size_t room=JSON_OBJECT_SIZE(p.size())+measureJson(p);
+        if(d.echo && d.echoCid==cid) room+=d.echo->memoryUsage();
+        auto* next=new DynamicJsonDocument(room);
+        JsonObject dst=next->to<JsonObject>();
+        if(d.echo && d.echoCid==cid) for(JsonPairConst kv:d.echo->as<JsonObjectConst>()) dst[kv.key()]=kv.value();
+        for(JsonPair kv:p) dst[kv.key()]=kv.value();
+        delete d.echo; d.echo=next; d.echoCid=cid;
+    }
+    void dropEcho(WsEndpointDesc& d){ delete d.echo; d.echo=nullptr; d.echoCid=0; }
+
+    /* стан усім (cid=0) або одному клієнту: повний — {"type":"p"}, за маскою — {"type":"d"} лише зі зміненими ключами,
+     * бо "p" клієнт підставляє цілим. У delta-режимі перший повний стан стає знімком, а одному клієнту віддається
+     * саме last — наступна "d" рахується від нього */
+    void sendState(WsEndpointDesc& d,uint32_t cid,const String& origin,state_change_mask_t changed,uint32_t author=0){
+        if(cid && d.delta && d.last){ refreshLast(d); enqueueState(d,cid,lastState(d,origin),"p",false); return; }
+        bool empty=false;
+        uint32_t rev=d.revisionFn(d.stateService);    // до читання: стан не старший за ревізію
+        DynamicJsonDocument doc=readState(d,origin,changed,rev,empty);
+        if(empty) return;                           // нічого з видимого не змінилось
+        enqueueState(d,cid,doc,changed==STATE_CHANGE_ALL ? "p" : "d",changed!=STATE_CHANGE_ALL,author);
+    }
+
+    /* повний стан одному клієнту без підписки: кадр серіалізується раз на ревізію й розсилку (у delta-режимі —
+     * раз на last), тож перезавантаження сторінки не перечитує стан і не чіпає інших клієнтів */
+    void sendSnapshot(WsEndpointDesc& d,uint32_t cid){
+        if(d.subs.count(cid)){ sendState(d,cid,WS_SNAPSHOT_ORIGIN,STATE_CHANGE_ALL); return; }
+        bool fromLast=d.delta && d.last;
+        if(fromLast) refreshLast(d);
+        uint32_t rev=fromLast ? d.lastRev : d.revisionFn(d.stateService);
+        if(!d.snapshot || d.snapshotRev!=rev || d.snapshotGen!=d.stateGen){
+            bool empty=false;
+            d.snapshot=serialize(fromLast ? lastState(d,WS_SNAPSHOT_ORIGIN)
+                                          : readState(d,WS_SNAPSHOT_ORIGIN,STATE_CHANGE_ALL,rev,empty));
+            d.snapshotRev=rev;
+            d.snapshotGen=d.stateGen;
+        }
+        enqueueBuffer(d,{cid},d.snapshot,true,true);
+    }
+
+    /* дописує в last поля, змінені без розсилки (на них ніхто не був підписаний); зміни, що чекають на токен,
+     * не чіпає — їх ще розішле broadcastDelta, тож і ревізія last лишається старою */
+    void refreshLast(WsEndpointDesc& d){
+        if(!d.lastStale) return;
+        state_change_mask_t stale=d.lastStale;
+        d.lastStale=0;
+        uint32_t rev=d.revisionFn(d.stateService);
+        DynamicJsonDocument cur=d.capacity->fill([&](JsonDocument& doc){
+            JsonObject p=doc.to<JsonObject>();
+            d.readFn(d.stateService,p);
+            for(auto &k:d.fieldKeys) if(!(k.field & stale)) p.remove(k.key);
+        });
+        size_t room=cur.memoryUsage()+d.last->memoryUsage();
+        DynamicJsonDocument patch(room);
+        WsMergePatch::diff(d.last->as<JsonObjectConst>(),cur.as<JsonObjectConst>(),patch.to<JsonObject>(),false);
+        if(patch.as<JsonObjectConst>().size()==0) return;
+
+        auto* next=new DynamicJsonDocument(room);
+        next->set(*d.last);
+        WsMergePatch::apply(next->as<JsonObject>(),patch.as<JsonObjectConst>());
+        next->shrinkToFit();
+        delete d.last; d.last=next;
+        if(!d.pendingMask) d.lastRev=rev;
+        d.stateGen++;
+    }
+
+    /* {"type":"p"} з last — того, від чого рахуватиметься наступна різниця */
+    DynamicJsonDocument lastState(WsEndpointDesc& d,const String& origin){
+        DynamicJsonDocument doc(d.last->memoryUsage()+JSON_OBJECT_SIZE(4)+origin.length()+1);
+        JsonObject root=doc.to<JsonObject>();
+        root["type"]="p"; root["origin_id"]=origin; root["rev"]=d.lastRev;
+        root["p"]=d.last->as<JsonObjectConst>();
+        return doc;
+    }
+
+    /* {"type":"p"} зі станом або {"type":"d"} з його частиною за маскою; у delta-режимі перший повний стан стає
+     * знімком для різниць */
+    DynamicJsonDocument readState(WsEndpointDesc& d,const String& origin,state_change_mask_t changed,uint32_t rev,
+                                  bool& empty){
+        const char* type=changed==STATE_CHANGE_ALL ? "p" : "d";
+        DynamicJsonDocument doc=d.capacity->fill([&](JsonDocument& doc){
+            JsonObject root=doc.to<JsonObject>();
+            root["type"]=type; root["origin_id"]=origin; root["rev"]=rev;
+            JsonObject p=root.createNestedObject(type);
+            d.readFn(d.stateService,p);
+            if(changed!=STATE_CHANGE_ALL){
+                for(auto &k:d.fieldKeys) if(!(k.field & changed)) p.remove(k.key);
+                empty=p.size()==0;
+            }
+        });
+        if(!empty && d.delta && !d.last && changed==STATE_CHANGE_ALL){
+            d.last=new DynamicJsonDocument(doc.memoryUsage());
+            d.last->set(doc["p"]);
+            d.lastRev=rev;
+        }
+        return doc;
+    }
+
+    /* різниця з останнім знімком; знімок = попередній + патч */
+    void broadcastDelta(WsEndpointDesc& d,const String& origin,state_change_mask_t changed,uint32_t author){
+        changed|=d.lastStale; d.lastStale=0;        // пропущене раніше йде тією ж різницею
+        uint32_t rev=d.revisionFn(d.stateService);
+        DynamicJsonDocument cur=d.capacity->fill([&](JsonDocument& doc){
+            JsonObject p=doc.to<JsonObject>();
+            d.readFn(d.stateService,p);
+            if(changed!=STATE_CHANGE_ALL)
+                for(auto &k:d.fieldKeys) if(!(k.field & changed)) p.remove(k.key);
+        });
 
-    /* обробка Tx */
+        size_t room=cur.memoryUsage()+d.last->memoryUsage()+JSON_OBJECT_SIZE(4)+origin.length()+1;
+        DynamicJsonDocument out(room);
+        JsonObject root=out.to<JsonObject>();
+        root["type"]="d"; root["origin_id"]=origin; root["rev"]=rev;
+        JsonObject patch=root.createNestedObject("d");
+        // маска прибрала ключі, що не змінились, — їх відсутність не означає видалення
+        WsMergePatch::diff(d.last->as<JsonObjectConst>(),cur.as<JsonObjectConst>(),patch,changed==STATE_CHANGE_ALL);
+        if(patch.size()==0) return;
+
+        auto* next=new DynamicJsonDocument(room);
+        next->set(*d.last);
+        WsMergePatch::apply(next->as<JsonObject>(),patch);
+        next->shrinkToFit();
+        delete d.last; d.last=next;
+        d.lastRev=rev; d.stateGen++;
+
+        enqueueState(d,0,out,"d",true,author);
+    }
+
+    /* --- розсилка з урахуванням підписок ---
+     * клієнти з однаковим набором ключів — одна група, один серіалізований буфер */
+    void enqueueState(WsEndpointDesc& d,uint32_t cid,const JsonDocument& doc,const char* payload,bool skipEmpty,
+                      uint32_t author=0){
+        if(cid){
+            auto s=d.subs.find(cid);
+            if(s==d.subs.end()) enqueueDoc(d,{cid},doc,true,true);
+            else                enqueueFiltered(d,{cid},doc,payload,s->second,skipEmpty);
+            return;
+        }
+        if(author) enqueueEcho(d,author,doc,payload);
+        if(d.subs.empty() && !author){ enqueueDoc(d,{},doc,true,true); return; }
+
+        std::vector<uint32_t> all;
+        std::map<std::vector<String>,std::vector<uint32_t>> groups;
+        for(auto &c:d.ws->getClients()){
+            if(c.status()!=WS_CONNECTED || c.id()==author) continue;
+            auto s=d.subs.find(c.id());
+            if(s==d.subs.end()) all.push_back(c.id());
+            else                groups[s->second].push_back(c.id());
+        }
+        if(!all.empty()) enqueueDoc(d,all,doc,true,true);
+        for(auto &g:groups) enqueueFiltered(d,g.second,doc,payload,g.first,skipEmpty);
+    }
+
+    void enqueueFiltered(WsEndpointDesc& d,const std::vector<uint32_t>& to,const JsonDocument& doc,
+                         const char* payload,const std::vector<String>& keys,bool skipEmpty){
+        if(keys.empty()) return;                    // підписка «нічого»
+        JsonObjectConst src=doc[payload];
+        size_t room=doc.memoryUsage();
+        for(auto &k:keys) room+=k.length()+1;       // ключі підписки копіюються
+        DynamicJsonDocument out(room);
+        for(JsonPairConst kv:doc.as<JsonObjectConst>()) if(kv.key()!=payload) out[kv.key()]=kv.value();
+        JsonObject p=out.createNestedObject(payload);
+        for(auto &k:keys) if(src.containsKey(k)) p[k]=src[k];
+        if(skipEmpty && p.size()==0) return;
+        enqueueDoc(d,to,out,true,true);
+    }
+
+    /* автору — лише ключі, що розійшлися з надісланим (сервер міг їх нормалізувати), або {"type":"ack","rev":N}.
+     * "p" клієнт підставляє цілим, тож його не урізаємо: або весь кадр, або ack */
+    void enqueueEcho(WsEndpointDesc& d,uint32_t author,const JsonDocument& doc,const char* payload){
+        auto s=d.subs.find(author);
+        bool patch=strcmp(payload,"d")==0;
+        JsonObjectConst src=doc[payload];
+        JsonObjectConst sent=d.echo->as<JsonObjectConst>();
+        DynamicJsonDocument out(doc.memoryUsage());
+        for(JsonPairConst kv:doc.as<JsonObjectConst>()) if(kv.key()!=payload) out[kv.key()]=kv.value();
+        JsonObject p=out.createNestedObject(payload);
+        bool differs=false;
+        for(JsonPairConst kv:src){
+            if(s!=d.subs.end() && !std::binary_search(s->second.begin(),s->second.end(),String(kv.key().c_str())))
+                continue;
+            JsonVariantConst mine=sent[kv.key()];
+            if(!mine.isNull() && mine==kv.value()) continue;
+            differs=true;
+            if(patch) p[kv.key()]=kv.value();
+        }
+        if(differs && !patch){ enqueueState(d,author,doc,payload,true); return; }
+        if(differs){ enqueueDoc(d,{author},out,true,true); return; }
+        StaticJsonDocument<96> ack;
+        ack["type"]="ack"; ack["rev"]=doc["rev"]; ack["origin_id"]=doc["origin_id"];
+        enqueueDoc(d,{author},ack,true);
+    }
+
+    /* біти полів, потрібні хоч комусь; ключ без fieldKeys або клієнт без підписки → усі */
+    state_change_mask_t subscribedFields(WsEndpointDesc& d){
+        if(d.subs.empty() || d.fieldKeys.empty()) return STATE_CHANGE_ALL;
+        state_change_mask_t fields=0;
+        for(auto &c:d.ws->getClients()){
+            if(c.status()!=WS_CONNECTED) continue;
+            auto s=d.subs.find(c.id());
+            if(s==d.subs.end()) return STATE_CHANGE_ALL;
+            for(auto &k:s->second){
+                auto f=std::find_if(d.fieldKeys.begin(),d.fieldKeys.end(),[&](const WsFieldKey& fk){ return k==fk.key; });
+                if(f==d.fieldKeys.end()) return STATE_CHANGE_ALL;
+                fields|=f->field;
+            }
+        }
+        return fields;
+    }
+
+    /* {"type":"sub",...}: форми розгортаються в ключі; без keys і forms — підписка скасовується */
+    void subscribe(WsEndpointDesc& d,uint32_t cid,JsonObject root){
+        if(!root.containsKey("keys") && !root.containsKey("forms")){ d.subs.erase(cid); return; }
+        std::vector<String> keys;
+        for(JsonVariant k:root["keys"].as<JsonArray>()) keys.push_back(k.as<String>());
+        for(JsonVariant f:root["forms"].as<JsonArray>()){
+            auto form=d.formKeys.find(f.as<String>());
+            if(form!=d.formKeys.end()) keys.insert(keys.end(),form->second.begin(),form->second.end());
+        }
+        std::sort(keys.begin(),keys.end());
+        keys.erase(std::unique(keys.begin(),keys.end()),keys.end());
+        d.subs[cid]=keys;
+    }
+
+    WsEndpointDesc* desc(ws_endpoint_t ep){
+        return ep<_dsc.size() ? &_dsc[ep] : nullptr;
+    }
+
+    WsEndpointDesc* find(const String& path){
+        uint32_t h=wsPathHash(path.c_str());
+        for(auto &d:_dsc) if(d.pathHash==h && d.path==path) return &d;
+        return nullptr;
+    }
+
+    static std::vector<uint32_t> cids(uint32_t cid){
+        return cid ? std::vector<uint32_t>{cid} : std::vector<uint32_t>{};
+    }
+
+    void enqueueDoc(WsEndpointDesc& d,const std::vector<uint32_t>& to,const JsonDocument& doc,bool txt,bool state=false){
+        enqueueBuffer(d,to,serialize(doc),txt,state);
+    }
+
+    static AsyncWebSocketSharedBuffer serialize(const JsonDocument& doc){
+        size_t len=measureJson(doc);
+        auto buf=std::make_shared<std::vector<uint8_t>>(len);
+        WsBufferPrint out(buf->data(),len);
+        serializeJson(doc,out);
+        return buf;
+    }
+
+    void enqueueBuffer(WsEndpointDesc& d,const std::vector<uint32_t>& to,AsyncWebSocketSharedBuffer buf,bool txt,
+                       bool state=false){
+        auto* it=new WsQueueItem{d.id,to,buf,txt,state};
+        if(xQueueSend(_txQ,&it,0)!=pdTRUE) delete it;
+        else if(_task && xTaskGetCurrentTaskHandle()!=_task) xTaskNotifyGive(_task);
+    }
+
+    /* обробка Tx: клієнти тримають посилання на спільний буфер, доки не відправлять */
     void processTx(){
+        unsigned long now=millis();
+        for(auto &d:_dsc){
+            if(d.pendingMask && !d.bucket.waitMs(now)) renderBroadcast(d,d.pendingOrigin,d.pendingMask);
+            flushBacklog(d,now);
+        }
         WsQueueItem* it=nullptr;
         while(xQueueReceive(_txQ,&it,0)==pdTRUE){
-            for(auto &d:_dsc) if(d.path==it->path){
-                if(it->cid==0){
-                    if(it->text) d.ws->textAll(it->payload);
-                    else         d.ws->binaryAll((uint8_t*)it->payload.c_str(),it->payload.length());
-                }else{
-                    auto* c=d.ws->client(it->cid);
-                    if(c && c->status()==WS_CONNECTED){
-                        if(it->text) c->text(it->payload);
-                        else         c->binary((uint8_t*)it->payload.c_str(),it->payload.length());
-                    }
-                }
-                break;
+            WsEndpointDesc& d=_dsc[it->ep];
+            if(it->cids.empty() && d.backlog.empty() && d.ws->availableForWriteAll() && (!it->state || allDue(d,now))){
+                if(it->text) d.ws->textAll(it->buf);
+                else         d.ws->binaryAll(it->buf);
+                for(auto &c:d.clients){ c.second.frames++; if(it->state) c.second.lastState=now; }
+            }else if(it->cids.empty()){
+                for(auto &c:d.ws->getClients()) if(c.status()==WS_CONNECTED) deliver(d,&c,*it,now);
+            }else for(uint32_t cid:it->cids){
+                auto* c=d.ws->client(cid);
+                if(c && c->status()==WS_CONNECTED) deliver(d,c,*it,now);
             }
             delete it;
         }
     }
 
-    /* обробка Rx */
+    /* кадр іде одразу, якщо клієнт вільний, нічого не чекає і (для стану) його інтервал минув;
+     * інакше стан згортається в прапорець, решта — в чергу */
+    void deliver(WsEndpointDesc& d,AsyncWebSocketClient* c,const WsQueueItem& it,unsigned long now){
+        WsClientStats& st=d.clients[c->id()];
+        st.intervalMs=clientInterval(st,c->queueLen());
+        bool due=!it.state || now-st.lastState>=st.intervalMs;
+        auto b=d.backlog.find(c->id());
+        if(b==d.backlog.end() && due && c->canSend()){
+            if(it.text) c->text(it.buf);
+            else        c->binary(it.buf);
+            st.frames++;
+            if(it.state) st.lastState=now;
+            return;
+        }
+        WsClientBacklog& bl=d.backlog[c->id()];
+        if(it.state){ if(bl.stale) st.coalesced++; bl.stale=true; }
+        else if(bl.ordered.size()<WS_MAX_ORDERED_MESSAGES) bl.ordered.emplace_back(it.buf,it.text);
+    }
+
+    static uint32_t clientInterval(const WsClientStats& st,size_t queued){
+        uint32_t ms=(uint32_t)(st.rtt*WS_CLIENT_RTT_FACTOR)+queued*WS_CLIENT_QUEUE_STEP_MS;
+        return ms<WS_CLIENT_MIN_INTERVAL_MS ? WS_CLIENT_MIN_INTERVAL_MS
+             : ms>WS_CLIENT_MAX_INTERVAL_MS ? WS_CLIENT_MAX_INTERVAL_MS : ms;
+    }
+
+    /* textAll оминає deliver(), тож інтервал кожного клієнта перераховується тут, з поточною глибиною його черги */
+    bool allDue(WsEndpointDesc& d,unsigned long now){
+        bool due=true;
+        for(auto &c:d.ws->getClients()){
+            auto s=d.clients.find(c.id());
+            if(c.status()!=WS_CONNECTED || s==d.clients.end()) continue;
+            WsClientStats& st=s->second;
+            st.intervalMs=clientInterval(st,c.queueLen());
+            if(now-st.lastState<st.intervalMs) due=false;
+        }
+        return due;
+    }
+
+    /* спершу впорядковані повідомлення, потім — один свіжий повний стан замість пропущених кадрів */
+    void flushBacklog(WsEndpointDesc& d,unsigned long now){
+        for(auto b=d.backlog.begin();b!=d.backlog.end();){
+            auto* c=d.ws->client(b->first);
+            if(!c || c->status()!=WS_CONNECTED){ b=d.backlog.erase(b); continue; }
+            WsClientBacklog& bl=b->second;
+            while(!bl.ordered.empty() && c->canSend()){
+                if(bl.ordered.front().second) c->text(bl.ordered.front().first);
+                else                          c->binary(bl.ordered.front().first);
+                bl.ordered.pop_front();
+            }
+            WsClientStats& st=d.clients[b->first];
+            if(!bl.ordered.empty() || (bl.stale && (!c->canSend() || now-st.lastState<st.intervalMs))){ ++b; continue; }
+            bool stale=bl.stale;
+            uint32_t cid=b->first;
+            b=d.backlog.erase(b);
+            if(stale) sendSnapshot(d,cid);       // у _txQ, доставить цей же processTx
+        }
+    }
+
+    /* обробка Rx: спершу повідомлення, потім події з'єднань — disconnect не випередить дані свого клієнта */
     void processRx(){
         WsIncomingItem* it=nullptr;
         while(xQueueReceive(_rxQ,&it,0)==pdTRUE){
-            StaticJsonDocument<1024> doc;
-            if(!deserializeJson(doc,it->payload) && doc.is<JsonObject>()){
-                JsonObject root=doc.as<JsonObject>();
-                if(root.containsKey("p") && root["p"].is<JsonObject>()){
-                    JsonObject p=root["p"];
-                    for(auto &d:_dsc) if(d.path==it->path){
-                        d.updateFn(p,d.stateService);
-                        break;
-                    }
-                }
-            }
+            processIncoming(*it);
             delete it;
         }
+        std::deque<WsIncomingItem> control;
+        xSemaphoreTake(_reqLock,portMAX_DELAY);
+        control.swap(_control);
+        xSemaphoreGive(_reqLock);
+        for(auto &ev:control) processIncoming(ev);
+    }
+
+    void processIncoming(const WsIncomingItem& it){
+        WsEndpointDesc* e=desc(it.ep);
+        if(!e) return;
+        WsEndpointDesc& d=*e;
+        uint32_t id=it.cid;
+        switch(it.kind){
+        case WS_IN_CONNECT:
+            d.clients[id].lastPong=it.at;
+            if(auto* c=d.ws->client(id)) sendId(d,c);
+            sendSnapshot(d,id);                  // решта клієнтів уже мають стан
+            break;
+        case WS_IN_PONG:{
+            d.clients[id].lastPong=it.at;
+            auto* c=d.ws->client(id);
+            if(_lastPingTs) updRtt(d.clients[id],it.at-_lastPingTs,c ? c->queueLen() : 0);
+            }
+            break;
+        case WS_IN_DISCONNECT:
+            d.clients.erase(id);
+            d.subs.erase(id);
+            d.backlog.erase(id);
+            break;
+        case WS_IN_DATA:
+            processMessage(d,id,it.payload);
+            break;
+        }
     }
 
-    /* ---------- WS events ---------- */
+    void processMessage(WsEndpointDesc& d,uint32_t cid,const String& payload){
+        DeserializationError err;
+        DynamicJsonDocument doc=d.capacity->parse([&](JsonDocument& doc){
+            return deserializeJson(doc,payload);
+        },&err);
+        if(err || !doc.is<JsonObject>()) return;
+        JsonObject root=doc.as<JsonObject>();
+        if(root["type"]=="resync"){
+            sendSnapshot(d,cid);
+        }else if(root["type"]=="sub"){
+            subscribe(d,cid,root);
+            sendState(d,cid,"sub",STATE_CHANGE_ALL);   // повний стан у межах нової підписки
+        }else if(root.containsKey("p") && root["p"].is<JsonObject>()){
+            JsonObject p=root["p"];
+            noteEcho(d,cid,p);                        // до update: без dispatch-задачі розсилка йде всередині нього
+            if(d.updateFn(p,d.stateService,wsOrigin(cid))!=StateUpdateResult::CHANGED && d.echoCid==cid) dropEcho(d);
+        }
+    }
+
+    /* ---------- WS events ----------
+     * приходять у задачі AsyncTCP: лише копіюються в _rxQ / _control, стан клієнтів змінює тільки dispatch */
     void handleWsEvent(WsEndpointDesc& d,AsyncWebSocketClient* c,
                        AwsEventType t,void* a,uint8_t* data,size_t len)
     {
         uint32_t id=c->id();
         switch(t){
-        case WS_EVT_CONNECT:
-            _lastPong[id]=millis();
-            sendId(c);
-            broadcastCurrentState(d.path,"ws_connect");
-            break;
-        case WS_EVT_PONG:
-            _lastPong[id]=millis();
-            if(_lastPingTs) updRtt(millis()-_lastPingTs);
-            break;
+        case WS_EVT_CONNECT:    enqueueRx(d.id,id,WS_IN_CONNECT);    break;
+        case WS_EVT_PONG:       enqueueRx(d.id,id,WS_IN_PONG);       break;
         case WS_EVT_DISCONNECT: case WS_EVT_ERROR:
-            _lastPong.erase(id);
-            break;
+                                d.rx->erase(id);
+                                enqueueRx(d.id,id,WS_IN_DISCONNECT); break;
         case WS_EVT_DATA:{
-            auto* info=(AwsFrameInfo*)a;
-            if(info->final && info->index==0 && info->opcode==WS_TEXT){
-                String s((char*)data,len);
-                enqueueRx(d.path,id,s,true);
-            }}
+            String s;                                // у чергу — лише повне повідомлення, розбір у dispatch
+            if(d.rx->feed(id,(AwsFrameInfo*)a,data,len,&s)) enqueueRx(d.id,id,WS_IN_DATA,s,true);
+            }
             break;
         default: break;
         }
         processAllQueues();
     }
 
-    void enqueueRx(const String& path,uint32_t cid,const String& pl,bool txt){
-        auto* it=new WsIncomingItem{path,cid,pl,txt};
+    /* повідомлення за повної черги відкидається; подію з'єднання губити не можна, а чекати в задачі AsyncTCP —
+     * теж, тож вона йде в _control (лише короткий _reqLock) */
+    void enqueueRx(ws_endpoint_t ep,uint32_t cid,WsIncomingKind kind,const String& pl=String(),bool txt=true){
+        if(kind!=WS_IN_DATA){
+            xSemaphoreTake(_reqLock,portMAX_DELAY);
+            _control.push_back(WsIncomingItem{ep,cid,kind,millis(),String(),txt});
+            xSemaphoreGive(_reqLock);
+            return;
+        }
+        auto* it=new WsIncomingItem{ep,cid,kind,millis(),pl,txt};
         if(xQueueSend(_rxQ,&it,0)!=pdTRUE) delete it;
     }
 
-    void sendId(AsyncWebSocketClient* c){
-        StaticJsonDocument<64> d; d["type"]="id"; d["id"]="ws:"+String(c->id());
-        String s; serializeJson(d,s); c->text(s);
+    void sendId(WsEndpointDesc& d,AsyncWebSocketClient* c){
+        StaticJsonDocument<64> doc; doc["type"]="id"; doc["id"]=wsOrigin(c->id());
+        enqueueDoc(d,{c->id()},doc,true);
     }
 
     /* ---- RTT / ping ---- */
-    static void staticPingCb(MultiWsManager* m){ if(m) { m->pingAll(); m->checkInactive(); } }
+    static void staticPingCb(MultiWsManager* m){ if(m){ m->_pingDue=true; m->processAllQueues(); } }
     void pingAll(){ _lastPingTs=millis(); for(auto &d:_dsc) d.ws->pingAll(); }
     void checkInactive(){
         unsigned long now=millis();
-        for(auto it=_lastPong.begin();it!=_lastPong.end();){
-            if(now-it->second>_pongTimeoutMs){ closeAll(it->first); it=_lastPong.erase(it);}
-            else ++it;
+        for(auto &d:_dsc){
+            std::vector<uint32_t> dead;                 // close() може одразу прислати DISCONNECT і змінити map
+            for(auto &c:d.clients) if(now-c.second.lastPong>_pongTimeoutMs) dead.push_back(c.first);
+            for(uint32_t cid:dead){
+                if(auto* c=d.ws->client(cid)) c->close();
+                d.clients.erase(cid); d.backlog.erase(cid); d.subs.erase(cid);
+            }
+        }
+    }
+    void updRtt(WsClientStats& st,unsigned long rtt,size_t queued){
+        st.rtt=st.hasRtt ? _alpha*rtt+(1-_alpha)*st.rtt : rtt;
+        st.hasRtt=true;
+        st.intervalMs=clientInterval(st,queued);
+    }
+
+    /* ---- dispatch: один прохід по всьому, що накопичилось ---- */
+    void lock()const  { xSemaphoreTakeRecursive(_lock,portMAX_DELAY); }
+    void unlock()const{ xSemaphoreGiveRecursive(_lock); }
+
+    void dispatch(){
+        lock();
+        if(_pingDue){ _pingDue=false; pingAll(); checkInactive(); }
+        processRx();
+        takeRequests();
+        processTx();
+        publishStats();
+        unlock();
+    }
+
+    /* збирається без _reqLock, під ним лише обмін векторів */
+    void publishStats(){
+        std::vector<WsClientStatsEntry> stats;
+        stats.reserve(_stats.size());
+        for(auto &d:_dsc) for(auto &c:d.ws->getClients()){
+            auto st=d.clients.find(c.id());
+            if(st==d.clients.end()) continue;
+            auto b=d.backlog.find(c.id());
+            stats.push_back(WsClientStatsEntry{d.path.c_str(),c.id(),st->second.rtt,st->second.hasRtt,c.queueLen(),
+                                               st->second.intervalMs,st->second.frames,st->second.coalesced,
+                                               b!=d.backlog.end() ? b->second.ordered.size() : 0});
+        }
+        xSemaphoreTake(_reqLock,portMAX_DELAY);
+        _stats.swap(stats);
+        xSemaphoreGive(_reqLock);
+    }
+
+    /* запити broadcastCurrentState, накопичені з інших задач; кілька змін між проходами — одна розсилка */
+    void takeRequests(){
+        for(auto &d:_dsc){
+            xSemaphoreTake(_reqLock,portMAX_DELAY);
+            state_change_mask_t changed=d.requestedMask; d.requestedMask=0;
+            String origin=d.requestedOrigin;
+            xSemaphoreGive(_reqLock);
+            if(changed) renderBroadcast(d,origin,changed);
+        }
+    }
+
+    /* є що доставити пізніше без нової події: кадр чекає на токен, інтервал клієнта чи його TCP-чергу */
+    bool hasDeferred()const{
+        for(auto &d:_dsc) if(d.pendingMask || !d.backlog.empty()) return true;
+        return false;
+    }
+
+    static void dispatchTask(void* arg){
+        auto* m=static_cast<MultiWsManager*>(arg);
+        for(;;){
+            ulTaskNotifyTake(pdTRUE,m->hasDeferred() ? pdMS_TO_TICKS(WS_DISPATCH_RETRY_MS) : portMAX_DELAY);
+            m->dispatch();
         }
     }
-    void updRtt(unsigned long rtt){ _avgRtt=_hasFirstRtt? _alpha*rtt+(1-_alpha)*_avgRtt : rtt; _hasFirstRtt=true; }
-    void closeAll(uint32_t cid){ for(auto &d:_dsc){ if(auto* c=d.ws->client(cid)) c->close(); } }
 };
 
 /* ---- end of file ---- */
@@ -34,7 +34,7 @@ class OTASettings {
   int port;
   String password;
 
-  static void read(OTASettings& settings, JsonObject& root) {
+  static void read(const OTASettings& settings, JsonObject& root) {
     root["enabled"] = settings.enabled;
     root["port"] = settings.port;
     root["password"] = settings.password;
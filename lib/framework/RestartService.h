@@ -11,6 +11,7 @@
 
 #include <ESPAsyncWebServer.h>
 #include <SecurityManager.h>
+#include <FSPersistenceWorker.h>
 
 #define RESTART_SERVICE_PATH "/rest/restart"
 
@@ -19,6 +20,8 @@ class RestartService {
   RestartService(AsyncWebServer* server, SecurityManager* securityManager);
 
   static void restartNow() {
+    // don't lose settings still waiting in the write-behind queue
+    FSPersistenceWorker::flushAll();
     WiFi.disconnect(true);
     // delay(500);
     vTaskDelay(500 / portTICK_PERIOD_MS);
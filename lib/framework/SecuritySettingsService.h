@@ -37,7 +37,7 @@ class SecuritySettings {
   String jwtSecret;
   std::list<User> users;
 
-  static void read(SecuritySettings& settings, JsonObject& root) {
+  static void read(const SecuritySettings& settings, JsonObject& root) {
     // secret
     root["jwt_secret"] = settings.jwtSecret;
 
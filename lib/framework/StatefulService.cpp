@@ -1,3 +1,4 @@
 #include <StatefulService.h>
 
 update_handler_id_t StateUpdateHandlerInfo::currentUpdatedHandlerId = 0;
+STATE_CHANGE_THREAD_LOCAL StateChangeRecorder* StateChangeRecorder::_current = nullptr;
@@ -4,13 +4,16 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include <atomic>
 #include <list>
 #include <functional>
+#include <memory>
 #ifdef ESP32
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #endif
 
+// Largest JSON document of an endpoint, the documents themselves are sized by JsonCapacity
 #ifndef DEFAULT_BUFFER_SIZE
 #define DEFAULT_BUFFER_SIZE 8192 //1024
 #endif
@@ -24,19 +27,64 @@ enum class StateUpdateResult {
 template <typename T>
 using JsonStateUpdater = std::function<StateUpdateResult(JsonObject& root, T& settings)>;
 
+// Readers only look at the state: in snapshot mode they all get the same published copy
 template <typename T>
-using JsonStateReader = std::function<void(T& settings, JsonObject& root)>;
+using JsonStateReader = std::function<void(const T& settings, JsonObject& root)>;
+
+// One bit per field (or group of fields) of a state class, assigned by the state class itself. Handlers receive the
+// bits changed since the last propagation; STATE_CHANGE_ALL is used whenever the updater did not record its changes.
+typedef uint32_t state_change_mask_t;
+#define STATE_CHANGE_ALL ((state_change_mask_t)0xFFFFFFFF)
+
+#ifdef ESP32
+#define STATE_CHANGE_THREAD_LOCAL thread_local
+#else
+#define STATE_CHANGE_THREAD_LOCAL
+#endif
+
+/**
+ * Collects the fields an updater changed. StatefulService installs a recorder around every updater call, the updater
+ * (usually via FormBuilder::updateValue) reports the bits it modified with StateChangeRecorder::record().
+ */
+class StateChangeRecorder {
+ public:
+  StateChangeRecorder() : _changes(0), _previous(_current) {
+    _current = this;
+  }
+  ~StateChangeRecorder() {
+    _current = _previous;
+  }
+
+  state_change_mask_t changes() const {
+    return _changes;
+  }
+
+  static void record(state_change_mask_t fields) {
+    if (_current) {
+      _current->_changes |= fields;
+    }
+  }
+
+ private:
+  state_change_mask_t _changes;
+  StateChangeRecorder* _previous;
+  static STATE_CHANGE_THREAD_LOCAL StateChangeRecorder* _current;
+};
 
 typedef size_t update_handler_id_t;
 typedef std::function<void(const String& originId)> StateUpdateCallback;
+typedef std::function<void(const String& originId, state_change_mask_t changed)> StateChangeCallback;
 
 typedef struct StateUpdateHandlerInfo {
   static update_handler_id_t currentUpdatedHandlerId;
   update_handler_id_t _id;
   StateUpdateCallback _cb;
+  StateChangeCallback _changeCb;
   bool _allowRemove;
   StateUpdateHandlerInfo(StateUpdateCallback cb, bool allowRemove) :
       _id(++currentUpdatedHandlerId), _cb(cb), _allowRemove(allowRemove){};
+  StateUpdateHandlerInfo(StateChangeCallback cb, bool allowRemove) :
+      _id(++currentUpdatedHandlerId), _changeCb(cb), _allowRemove(allowRemove){};
 } StateUpdateHandlerInfo_t;
 
 template <class T>
@@ -45,10 +93,15 @@ class StatefulService {
   template <typename... Args>
 #ifdef ESP32
   StatefulService(Args&&... args) :
-      _state(std::forward<Args>(args)...), _accessMutex(xSemaphoreCreateRecursiveMutex()) {
+      _state(std::forward<Args>(args)...),
+      _revision(0),
+      _pendingChanges(0),
+      _snapshotsEnabled(false),
+      _accessMutex(xSemaphoreCreateRecursiveMutex()) {
   }
 #else
-  StatefulService(Args&&... args) : _state(std::forward<Args>(args)...) {
+  StatefulService(Args&&... args) :
+      _state(std::forward<Args>(args)...), _revision(0), _pendingChanges(0), _snapshotsEnabled(false) {
   }
 #endif
 
@@ -61,6 +114,16 @@ class StatefulService {
     return updateHandler._id;
   }
 
+  // like addUpdateHandler, the callback also receives the mask of fields changed since the last propagation
+  update_handler_id_t addChangeHandler(StateChangeCallback cb, bool allowRemove = true) {
+    if (!cb) {
+      return 0;
+    }
+    StateUpdateHandlerInfo_t updateHandler(cb, allowRemove);
+    _updateHandlers.push_back(updateHandler);
+    return updateHandler._id;
+  }
+
   void removeUpdateHandler(update_handler_id_t id) {
     for (auto i = _updateHandlers.begin(); i != _updateHandlers.end();) {
       if ((*i)._allowRemove && (*i)._id == id) {
@@ -73,8 +136,9 @@ class StatefulService {
 
   StateUpdateResult update(std::function<StateUpdateResult(T&)> stateUpdater, const String& originId) {
     beginTransaction();
+    StateChangeRecorder recorder;
     StateUpdateResult result = stateUpdater(_state);
-    endTransaction();
+    commitTransaction(result, recorder.changes());
     if (result == StateUpdateResult::CHANGED) {
       callUpdateHandlers(originId);
     }
@@ -83,15 +147,17 @@ class StatefulService {
 
   StateUpdateResult updateWithoutPropagation(std::function<StateUpdateResult(T&)> stateUpdater) {
     beginTransaction();
+    StateChangeRecorder recorder;
     StateUpdateResult result = stateUpdater(_state);
-    endTransaction();
+    commitTransaction(result, recorder.changes());
     return result;
   }
 
   StateUpdateResult update(JsonObject& jsonObject, JsonStateUpdater<T> stateUpdater, const String& originId) {
     beginTransaction();
+    StateChangeRecorder recorder;
     StateUpdateResult result = stateUpdater(jsonObject, _state);
-    endTransaction();
+    commitTransaction(result, recorder.changes());
     if (result == StateUpdateResult::CHANGED) {
       callUpdateHandlers(originId);
     }
@@ -100,26 +166,73 @@ class StatefulService {
 
   StateUpdateResult updateWithoutPropagation(JsonObject& jsonObject, JsonStateUpdater<T> stateUpdater) {
     beginTransaction();
+    StateChangeRecorder recorder;
     StateUpdateResult result = stateUpdater(jsonObject, _state);
-    endTransaction();
+    commitTransaction(result, recorder.changes());
     return result;
   }
 
   void read(std::function<void(T&)> stateReader) {
+    if (_snapshotsEnabled) {
+      // the snapshot is shared with the other readers, a reader that writes to its state must not reach it
+      T state(*std::atomic_load(&_snapshot));
+      stateReader(state);
+      return;
+    }
     beginTransaction();
     stateReader(_state);
     endTransaction();
   }
 
   void read(JsonObject& jsonObject, JsonStateReader<T> stateReader) {
+    if (_snapshotsEnabled) {
+      std::shared_ptr<const T> snapshot = std::atomic_load(&_snapshot);
+      stateReader(*snapshot, jsonObject);
+      return;
+    }
     beginTransaction();
     stateReader(_state, jsonObject);
     endTransaction();
   }
 
+  // Snapshot mode: every committed change publishes an immutable copy of the state and readers work on the latest
+  // copy instead of taking the access mutex, so slow readers never block writers (or each other). JSON readers and
+  // snapshot() share that copy as const; read(std::function<void(T&)>) hands its reader a private copy. Enable once the
+  // state is initialised; costs one copy of T per change.
+  void enableSnapshots() {
+    beginTransaction();
+    publishSnapshot();
+    _snapshotsEnabled = true;
+    endTransaction();
+  }
+
+  // latest published copy, null until enableSnapshots() is called
+  std::shared_ptr<const T> snapshot() const {
+    return std::atomic_load(&_snapshot);
+  }
+
+  // incremented on every committed change
+  uint32_t revision() const {
+    return _revision.load();
+  }
+
+  // propagates the changes committed since the last call
   void callUpdateHandlers(const String& originId) {
+    beginTransaction();
+    state_change_mask_t changed = _pendingChanges ? _pendingChanges : STATE_CHANGE_ALL;
+    _pendingChanges = 0;
+    endTransaction();
+    callUpdateHandlers(originId, changed);
+  }
+
+  // for services that modify _state directly and know which fields they touched
+  void callUpdateHandlers(const String& originId, state_change_mask_t changed) {
     for (const StateUpdateHandlerInfo_t& updateHandler : _updateHandlers) {
-      updateHandler._cb(originId);
+      if (updateHandler._changeCb) {
+        updateHandler._changeCb(originId, changed);
+      } else {
+        updateHandler._cb(originId);
+      }
     }
   }
 
@@ -138,10 +251,35 @@ class StatefulService {
 #endif
   }
 
+  // For services that modify _state directly: call between beginTransaction() and endTransaction() after a change
+  // so the revision moves on and snapshot readers see it.
+  void markChanged() {
+    _revision++;
+    if (_snapshotsEnabled) {
+      publishSnapshot();
+    }
+  }
+
  private:
+  std::atomic<uint32_t> _revision;
+  state_change_mask_t _pendingChanges;
+  bool _snapshotsEnabled;
+  std::shared_ptr<const T> _snapshot;
 #ifdef ESP32
   SemaphoreHandle_t _accessMutex;
 #endif
+
+  inline void commitTransaction(StateUpdateResult result, state_change_mask_t changes) {
+    if (result == StateUpdateResult::CHANGED) {
+      _pendingChanges |= changes ? changes : STATE_CHANGE_ALL;
+      markChanged();
+    }
+    endTransaction();
+  }
+
+  void publishSnapshot() {
+    std::atomic_store(&_snapshot, std::shared_ptr<const T>(std::make_shared<T>(_state)));
+  }
   std::list<StateUpdateHandlerInfo_t> _updateHandlers;
 };
 
@@ -18,6 +18,7 @@ TelegramService::TelegramService(AsyncWebServer* srv,FS*fs,
                                            TelegramSettings::staRead,
                                            TelegramSettings::staUpd);
     }
+    _fs.setPersistedFields(TelegramSettings::CONFIG_FIELDS);   // лог/черга не пишуться у флеш
     _q = xQueueCreate(TEL_Q_MAX, sizeof(TelegramQueuedMessage*));
 }
 
@@ -65,7 +66,7 @@ void TelegramService::enqueueMessage(const String& chatId,
         return;
     }
     _state.qSize = uxQueueMessagesWaiting(_q);
-    callUpdateHandlers("sta"); // WS канал "sta"
+    callUpdateHandlers("sta", TelegramSettings::F_QUEUE); // WS канал "sta"
 }
 
 /* ---------- TLS POST у Telegram API ---------- */
@@ -138,7 +139,7 @@ void TelegramService::appendLogLine(const String& line){
     }
     _state.manualLogRO = ro;
 
-    callUpdateHandlers("sta");
+    callUpdateHandlers("sta", TelegramSettings::F_LOG);
 }
 
 void TelegramService::tryConsumeManualSendRequest(){
@@ -166,7 +167,7 @@ void TelegramService::tryConsumeManualSendRequest(){
         // СКИДАЄМО СТАН КНОПКИ → "0" у WS, очищаємо текст
         _state.manualSend = false;
         _state.manualText = "";
-        callUpdateHandlers("sta");
+        callUpdateHandlers("sta", TelegramSettings::F_MANUAL);
     }
 }
 
@@ -207,7 +208,7 @@ void TelegramService::task(void* pv){
 
             delete m;
             s->_state.qSize = uxQueueMessagesWaiting(s->_q);
-            s->callUpdateHandlers("sta");
+            s->callUpdateHandlers("sta", TelegramSettings::F_QUEUE | TelegramSettings::F_LAST);
             vTaskDelay(pdMS_TO_TICKS(s->_state.sendDelay));
         } else {
             vTaskDelay(pdMS_TO_TICKS(20));
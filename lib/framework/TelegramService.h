@@ -3,6 +3,7 @@
 #include <HttpEndpoint.h>
 #include <FSPersistence.h>
 #include <FormBuilder.h>
+#include <FieldBindings.h>
 #include <UniversalTelegramBot.h>
 #include <WiFiClientSecure.h>
 #include <NewMultiWsService.h>
@@ -14,8 +15,23 @@
 
 /* ================= SETTINGS ================= */
 struct TelegramSettings {
+    /* біти полів для масок змін: конфіг зберігається у FS, runtime — ні */
+    enum Field : state_change_mask_t {
+        F_TOKEN   = 1u << 0,
+        F_CHAT    = 1u << 1,
+        F_TOPIC   = 1u << 2,
+        F_ENABLED = 1u << 3,
+        F_DELAY   = 1u << 4,
+        F_QUEUE   = 1u << 5,   // qsize
+        F_LAST    = 1u << 6,   // last, sent
+        F_LOG     = 1u << 7,   // chatLog, manualLogRO
+        F_MANUAL  = 1u << 8,   // manualText, manualSend
+    };
+    static constexpr state_change_mask_t CONFIG_FIELDS = F_TOKEN | F_CHAT | F_TOPIC | F_ENABLED | F_DELAY;
+
     /* runtime */
-    String lastMsg;  int qSize{0}; bool sent{false};
+    String lastMsg;  int qSize{0};
+    mutable bool sent{false};          // одноразовий: staRead віддає його по WS і скидає
 
     // Кільцевий лог для чату
     static constexpr uint8_t LOG_MAX = 50;
@@ -32,10 +48,25 @@ struct TelegramSettings {
     bool   enabled{false};
     unsigned long sendDelay{10000};
 
+    /* ----- ключі стану: ключ → член і біт маски (WS/FS readers, update) -----
+     * поза таблицею: delay (unsigned long, приймається й рядком), m_send ("1"/"0"), лог і одноразовий sent */
+    static const FieldTable<TelegramSettings>& fields(){
+        static const FieldBinding<TelegramSettings> bindings[] = {
+            {"qsize",  &TelegramSettings::qSize,      F_QUEUE,   FieldDescriptor{nullptr}, BIND_STATE},
+            {"last",   &TelegramSettings::lastMsg,    F_LAST,    FieldDescriptor{nullptr}, BIND_STATE},
+            {"m_text", &TelegramSettings::manualText, F_MANUAL,  FieldDescriptor{nullptr}, BIND_STATE},
+            {"token",  &TelegramSettings::botToken,   F_TOKEN,   FieldDescriptor{nullptr}, BIND_STATE | BIND_CONFIG | BIND_UPDATE},
+            {"chat",   &TelegramSettings::chatId,     F_CHAT,    FieldDescriptor{nullptr}, BIND_STATE | BIND_CONFIG | BIND_UPDATE},
+            {"topic",  &TelegramSettings::topicId,    F_TOPIC,   FieldDescriptor{nullptr}, BIND_STATE | BIND_CONFIG | BIND_UPDATE},
+            {"ena",    &TelegramSettings::enabled,    F_ENABLED, FieldDescriptor{nullptr}, BIND_STATE | BIND_CONFIG | BIND_UPDATE},
+        };
+        static const FieldTable<TelegramSettings> table(bindings);
+        return table;
+    }
+
     /* ----- WS: sta (як у LightState) ----- */
-    static void staRead(TelegramSettings& s, JsonObject& root){
-        root["qsize"] = s.qSize;
-        root["last"]  = s.lastMsg;
+    static void staRead(const TelegramSettings& s, JsonObject& root){
+        fields().read(s, root, BIND_STATE);
         root["sent"]  = s.sent;  s.sent = false;
 
         JsonArray log = root.createNestedArray("log");
@@ -45,18 +76,11 @@ struct TelegramSettings {
             if(i) joined += "\n";
             joined += s.chatLog[i];
         }
-        root["m_text"] = s.manualText;
         root["m_log"]  = joined;
 
         // ВАЖЛИВО: віддаємо як "1"/"0" (рядок), бо фронт працює з такими значеннями
         root["m_send"] = s.manualSend ? "1" : "0";
-
-        // опційно — віддати конфіг по WS
-        root["token"] = s.botToken;
-        root["chat"]  = s.chatId;
-        root["topic"] = s.topicId;
-        root["ena"]   = s.enabled;
-        root["delay"] = s.sendDelay;
+        root["delay"]  = s.sendDelay;
     }
 
     static bool parseOneZeroBool(JsonVariantConst v){
@@ -72,24 +96,9 @@ struct TelegramSettings {
         return false;
     }
 
-    static StateUpdateResult staUpd(JsonObject& in, TelegramSettings& s){
-        bool cfgChanged = false;
-
-        // Runtime: текст
-        (void)FormBuilder::updateValue(in, "m_text", s.manualText);
-
-        // Кнопка: читаємо "1"/"0" тощо й виставляємо стан
-        if (in.containsKey("m_send")) {
-            s.manualSend = parseOneZeroBool(in["m_send"]);
-        }
-
-        // Дозволимо редагувати конфіг через WS (опційно)
-        cfgChanged |= FormBuilder::updateValue(in, "token", s.botToken);
-        cfgChanged |= FormBuilder::updateValue(in, "chat",  s.chatId);
-        cfgChanged |= FormBuilder::updateValue(in, "topic", s.topicId);
-
-        bool enaTmp = s.enabled;
-        if (FormBuilder::updateValue(in, "ena", enaTmp)) { s.enabled = enaTmp; cfgChanged = true; }
+    /* спільне для WS, REST і FS: конфіг з таблиці + delay; текст і кнопка — runtime, результату не змінюють */
+    static StateUpdateResult updateFrom(JsonObject& in, TelegramSettings& s){
+        bool cfgChanged = fields().update(in, s) == StateUpdateResult::CHANGED;
 
         if (in.containsKey("delay")) {
             unsigned long newDelay = s.sendDelay;
@@ -99,23 +108,30 @@ struct TelegramSettings {
                 const char* cs = in["delay"].as<const char*>();
                 if (cs && *cs) newDelay = strtoul(cs, nullptr, 10);
             }
-            if (newDelay != s.sendDelay) { s.sendDelay = newDelay; cfgChanged = true; }
+            if (newDelay != s.sendDelay) { s.sendDelay = newDelay; cfgChanged = true; StateChangeRecorder::record(F_DELAY); }
+        }
+
+        (void)FormBuilder::updateValue(in, "m_text", s.manualText, F_MANUAL);
+        if (in.containsKey("m_send")) {
+            s.manualSend = parseOneZeroBool(in["m_send"]);
+            StateChangeRecorder::record(F_MANUAL);
         }
 
         return cfgChanged ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
     }
 
+    static StateUpdateResult staUpd(JsonObject& in, TelegramSettings& s){
+        return updateFrom(in, s);
+    }
+
     /* ----- CONFIG (тільки ключі settings; для FS) ----- */
-    static void readConfig(TelegramSettings& s, JsonObject& root) {
-        root["token"] = s.botToken;
-        root["chat"]  = s.chatId;
-        root["topic"] = s.topicId;
-        root["ena"]   = s.enabled;
+    static void readConfig(const TelegramSettings& s, JsonObject& root) {
+        fields().read(s, root, BIND_CONFIG);
         root["delay"] = s.sendDelay;
     }
 
     /* ----- REST форми ----- */
-    static void readForm(TelegramSettings& s, JsonObject& root){
+    static void readForm(const TelegramSettings& s, JsonObject& root){
         // STATUS
         JsonArray st = FormBuilder::createForm(root,"status","Status");
         FormBuilder::addNumberField(st,"qsize",AF::R,s.qSize);
@@ -138,39 +154,12 @@ struct TelegramSettings {
 
     // Універсальний апдейт (REST + FS)
     static StateUpdateResult upd(JsonObject& j, TelegramSettings& s){
-        bool cfgChanged = false;
-
         // Плоский формат або вкладений "settings"
         JsonObject src = j;
         if (j.containsKey("settings") && j["settings"].is<JsonObject>()) {
             src = j["settings"].as<JsonObject>();
         }
-
-        cfgChanged |= FormBuilder::updateValue(src, "token", s.botToken);
-        cfgChanged |= FormBuilder::updateValue(src, "chat",  s.chatId);
-        cfgChanged |= FormBuilder::updateValue(src, "topic", s.topicId);
-
-        bool enaTmp = s.enabled;
-        if (FormBuilder::updateValue(src, "ena", enaTmp)) { s.enabled = enaTmp; cfgChanged = true; }
-
-        if (src.containsKey("delay")) {
-            unsigned long newDelay = s.sendDelay;
-            if (src["delay"].is<uint32_t>() || src["delay"].is<int>() || src["delay"].is<unsigned long>()) {
-                newDelay = (unsigned long)src["delay"].as<uint32_t>();
-            } else if (src["delay"].is<const char*>()) {
-                const char* cs = src["delay"].as<const char*>();
-                if (cs && *cs) newDelay = strtoul(cs, nullptr, 10);
-            }
-            if (newDelay != s.sendDelay) { s.sendDelay = newDelay; cfgChanged = true; }
-        }
-
-        // REST також може прислати кнопку/текст — це runtime
-        (void)FormBuilder::updateValue(src, "m_text", s.manualText);
-        if (src.containsKey("m_send")) {
-            s.manualSend = parseOneZeroBool(src["m_send"]);
-        }
-
-        return cfgChanged ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
+        return updateFrom(src, s);
     }
 };
 
@@ -9,7 +9,12 @@
 #include <map>
 #include <queue>
 #include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <SecurityManager.h>   // Якщо потрібно
+#include <WsTokenBucket.h>
+#include <WsReassembler.h>
 
 // Підключаємо заголовок із сучасного форку
 #include <AsyncWebSocket.h>
@@ -76,6 +81,20 @@ private:
 #define MAX_TX_MESSAGES_PER_SECOND 5
 #endif
 
+// Скільки кадрів стану можна відправити підряд, перш ніж діятиме ліміт
+#ifndef WS_TX_BURST
+#define WS_TX_BURST 2
+#endif
+
+// Один токен на TRANSMIT_INTERVAL_MS, але не частіше за MAX_TX_MESSAGES_PER_SECOND
+#define WS_TX_REFILL_MS \
+    (TRANSMIT_INTERVAL_MS > 1000 / MAX_TX_MESSAGES_PER_SECOND ? TRANSMIT_INTERVAL_MS : 1000 / MAX_TX_MESSAGES_PER_SECOND)
+
+// Задача відкладеного flush-у (створюється при першому спрацюванні ліміту): читання, серіалізація й textAll
+#ifndef WS_TX_FLUSH_TASK_STACK_SIZE
+#define WS_TX_FLUSH_TASK_STACK_SIZE 4096
+#endif
+
 //--------------------------------------------------------------------------
 // Базовий клас WebSocketConnector<T> з підтримкою Ping-Pong
 //--------------------------------------------------------------------------
@@ -91,6 +110,8 @@ protected:
 
     std::map<uint32_t, size_t> _clientMessageCounts;
     std::map<uint32_t, std::queue<AsyncWebSocketMessage*>> _clientMessageQueues;
+    // Не більше одного відкладеного кадру стану на клієнта: новіший замінює старіший
+    std::map<uint32_t, AsyncWebSocketMessage*> _clientPendingState;
     std::map<uint32_t, unsigned long> _lastPongTime;
 
     Ticker _pingTicker;
@@ -263,6 +284,11 @@ protected:
             }
             _clientMessageQueues.erase(it);
         }
+        auto pending = _clientPendingState.find(clientId);
+        if (pending != _clientPendingState.end()) {
+            delete pending->second;
+            _clientPendingState.erase(pending);
+        }
     }
 
     void enqueueMessage(uint32_t clientId, AsyncWebSocketMessage* message) {
@@ -275,6 +301,18 @@ protected:
         }
     }
 
+    // Кадр стану: старіший відкладений кадр уже нікому не потрібен
+    void enqueueStateMessage(uint32_t clientId, AsyncWebSocketMessage* message) {
+        auto pending = _clientPendingState.find(clientId);
+        if (pending != _clientPendingState.end()) {
+            delete pending->second;
+            pending->second = message;
+        } else {
+            _clientPendingState[clientId] = message;
+            incrementMessageCount(clientId);
+        }
+    }
+
     void processMessageQueue(uint32_t clientId) {
         AsyncWebSocketClient* c = _webSocket.client(clientId);
         if (!c) return;
@@ -292,6 +330,16 @@ protected:
                 break;
             }
         }
+
+        // Стан — після впорядкованих повідомлень (id тощо)
+        auto pending = _clientPendingState.find(clientId);
+        if (pending != _clientPendingState.end() && _clientMessageQueues[clientId].empty() && c->canSend()) {
+            if (pending->second->send(c->client())) {
+                decrementMessageCount(clientId);
+                delete pending->second;
+                _clientPendingState.erase(pending);
+            }
+        }
     }
 
     String makeClientId(AsyncWebSocketClient* client) {
@@ -324,10 +372,7 @@ public:
                               authPred,
                               bufferSize),
         _stateReader(stateReader),
-        lastTransmitTime(0),
-        messagesSentThisSecond(0),
-        lastSecondMark(0),
-        transmitInterval(TRANSMIT_INTERVAL_MS)
+        _bucket(WS_TX_BURST, WS_TX_REFILL_MS)
     {
         this->_statefulService->addUpdateHandler(
             [&](const String& originId) { scheduleTransmitData(originId); },
@@ -346,10 +391,7 @@ public:
                               webSocketPath,
                               bufferSize),
         _stateReader(stateReader),
-        lastTransmitTime(0),
-        messagesSentThisSecond(0),
-        lastSecondMark(0),
-        transmitInterval(TRANSMIT_INTERVAL_MS)
+        _bucket(WS_TX_BURST, WS_TX_REFILL_MS)
     {
         this->_statefulService->addUpdateHandler(
             [&](const String& originId) { scheduleTransmitData(originId); },
@@ -357,21 +399,38 @@ public:
         );
     }
 
+    virtual ~WebSocketTx() {
+        _flushTicker.detach();
+        if (_flushTask) vTaskDelete(_flushTask);
+        vSemaphoreDelete(_pendingLock);
+    }
+
+    // Ліміт цього endpoint-у: burst кадрів підряд, далі один на intervalMs (0 — без ліміту)
+    void setRateLimit(uint8_t burst, uint32_t intervalMs) {
+        _bucket.configure(burst, intervalMs);
+    }
+
+    // Зміна, що не вмістилась у ліміт, не губиться: відкладений flush відправить найсвіжіший стан.
+    // Викликається з задач update-handler-ів і flush-задачі, тож ліміт і відкладене — під _pendingLock
     void scheduleTransmitData(const String& originId) {
         unsigned long now = millis();
-
-        if (now - lastSecondMark >= 1000) {
-            lastSecondMark = now;
-            messagesSentThisSecond = 0;
-        }
-        if (messagesSentThisSecond >= MAX_TX_MESSAGES_PER_SECOND) {
+        xSemaphoreTake(_pendingLock, portMAX_DELAY);
+        if (_bucket.tryAcquire(now)) {
+            _flushTicker.detach();
+            _flushPending = false;
+            xSemaphoreGive(_pendingLock);
+            transmitData(nullptr, originId);
             return;
         }
-        if (now - lastTransmitTime >= transmitInterval) {
-            transmitData(nullptr, originId);
-            lastTransmitTime = now;
-            messagesSentThisSecond++;
+        // зміни різних авторів зливаються в один кадр — тоді автора нема і луна не придушується
+        _pendingOrigin = !_flushPending || _pendingOrigin == originId ? originId : String();
+        if (!_flushPending && (_flushTask || xTaskCreate(flushTask, "WsTxFlush", WS_TX_FLUSH_TASK_STACK_SIZE, this, 1,
+                                                         &_flushTask) == pdPASS)) {
+            _flushPending = true;
+            uint32_t wait = _bucket.waitMs(now);
+            _flushTicker.once_ms(wait ? wait : 1, staticFlush, this);
         }
+        xSemaphoreGive(_pendingLock);
     }
 
 protected:
@@ -391,11 +450,30 @@ protected:
 private:
     JsonStateReader<T> _stateReader;
 
-    unsigned long lastTransmitTime;
-    unsigned long transmitInterval;
+    WsTokenBucket _bucket;
+    Ticker        _flushTicker;
+    SemaphoreHandle_t _pendingLock = xSemaphoreCreateMutex();   // _bucket, _flushPending, _pendingOrigin
+    bool          _flushPending = false;
+    String        _pendingOrigin;
+    TaskHandle_t  _flushTask = nullptr;
 
-    unsigned int messagesSentThisSecond;
-    unsigned long lastSecondMark;
+    // задача esp_timer: лише будить flush-задачу, стан читається й відправляється вже там
+    static void staticFlush(WebSocketTx<T>* instance) {
+        xTaskNotifyGive(instance->_flushTask);
+    }
+
+    static void flushTask(void* arg) {
+        auto* instance = static_cast<WebSocketTx<T>*>(arg);
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            xSemaphoreTake(instance->_pendingLock, portMAX_DELAY);
+            bool pending = instance->_flushPending;
+            String origin = instance->_pendingOrigin;
+            instance->_flushPending = false;
+            xSemaphoreGive(instance->_pendingLock);
+            if (pending) instance->scheduleTransmitData(origin);
+        }
+    }
 
     void transmitId(AsyncWebSocketClient* client) {
         uint32_t cid = client->id();
@@ -423,17 +501,59 @@ private:
         }
     }
 
+    // клієнт цього endpoint-у, чия зміна розсилається (origin "ws:<id>")
+    AsyncWebSocketClient* authorOf(const String& originId) {
+        if (!originId.startsWith(WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX)) return nullptr;
+        AsyncWebSocketClient* c =
+            this->_webSocket.client(originId.substring(strlen(WEB_SOCKET_ORIGIN_CLIENT_ID_PREFIX)).toInt());
+        return c && c->status() == WS_CONNECTED && this->makeClientId(c) == originId ? c : nullptr;
+    }
+
+    // Автор уже має стан, який щойно надіслав (WebSocketRx приймає його цілим) — йому лише ревізія
+    void transmitAck(AsyncWebSocketClient* client, const String& originId, uint32_t revision) {
+        DynamicJsonDocument doc(WEB_SOCKET_CLIENT_ID_MSG_SIZE);
+        doc["type"]      = "ack";
+        doc["rev"]       = revision;
+        doc["origin_id"] = originId;
+
+        size_t len = measureJson(doc);
+        AsyncWebSocketMessageBuffer* buffer = this->_webSocket.makeBuffer(len);
+        if (!buffer) return;
+
+        serializeJson(doc, (char*)buffer->get(), len + 1);
+
+        if (client->canSend()) {
+            client->text(buffer);
+            this->incrementMessageCount(client->id());
+        } else {
+            this->enqueueMessage(
+                client->id(),
+                new AsyncWebSocketBasicMessage((const char*)buffer->get(), len, WS_TEXT, false)
+            );
+            delete buffer;
+        }
+    }
+
     void transmitData(AsyncWebSocketClient* client, const String& originId) {
         uint32_t cid = client ? client->id() : 0;
+        AsyncWebSocketClient* author = client ? nullptr : authorOf(originId);
+        uint32_t revision = this->_statefulService->revision();
 
         DynamicJsonDocument doc(this->_bufferSize);
         JsonObject root = doc.to<JsonObject>();
         root["type"]      = "p";
         root["origin_id"] = originId;
+        root["rev"]       = revision;
         JsonObject p      = root.createNestedObject("p");
 
         this->_statefulService->read(p, _stateReader);
 
+        if (author) {
+            transmitAck(author, originId, revision);
+            transmitExcept(author, doc);
+            return;
+        }
+
         size_t len = measureJson(doc);
         AsyncWebSocketMessageBuffer* buffer = this->_webSocket.makeBuffer(len);
         if (!buffer) return;
@@ -445,7 +565,7 @@ private:
                 client->text(buffer);
                 this->incrementMessageCount(cid);
             } else {
-                this->enqueueMessage(
+                this->enqueueStateMessage(
                     cid,
                     new AsyncWebSocketBasicMessage((const char*)buffer->get(), len, WS_TEXT, false)
                 );
@@ -458,6 +578,27 @@ private:
             }
         }
     }
+
+    // Усім, крім автора: один спільний буфер замість textAll
+    void transmitExcept(AsyncWebSocketClient* author, const JsonDocument& doc) {
+        size_t len = measureJson(doc);
+        AsyncWebSocketSharedBuffer buffer = std::make_shared<std::vector<uint8_t>>(len + 1);
+        serializeJson(doc, (char*)buffer->data(), len + 1);
+        buffer->resize(len);
+
+        for (auto& c : this->_webSocket.getClients()) {
+            if (&c == author || c.status() != WS_CONNECTED) continue;
+            if (c.canSend()) {
+                c.text(buffer);
+                this->incrementMessageCount(c.id());
+            } else {
+                this->enqueueStateMessage(
+                    c.id(),
+                    new AsyncWebSocketBasicMessage((const char*)buffer->data(), len, WS_TEXT, false)
+                );
+            }
+        }
+    }
 };
 
 // --------------------------------------------------------------------------
@@ -503,11 +644,15 @@ protected:
                    uint8_t*             data,
                    size_t               len) override
     {
-        if (type == WS_EVT_DATA) {
-            AwsFrameInfo* info = (AwsFrameInfo*)arg;
-            if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
+        if (type == WS_EVT_DISCONNECT || type == WS_EVT_ERROR) {
+            _reassembler.erase(client->id());
+        }
+        else if (type == WS_EVT_DATA) {
+            // розбираємо лише повне повідомлення, хоч би на скільки подій його розбив TCP
+            String message;
+            if (_reassembler.feed(client->id(), (AwsFrameInfo*)arg, data, len, &message)) {
                 DynamicJsonDocument doc(this->_bufferSize);
-                DeserializationError err = deserializeJson(doc, (char*)data);
+                DeserializationError err = deserializeJson(doc, message);
                 if (!err && doc.is<JsonObject>()) {
                     JsonObject jsonObject = doc.as<JsonObject>();
                     this->_statefulService->update(
@@ -522,6 +667,7 @@ protected:
 
 private:
     JsonStateUpdater<T> _stateUpdater;
+    WsReassembler       _reassembler;
 };
 
 // --------------------------------------------------------------------------
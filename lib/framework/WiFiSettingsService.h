@@ -39,7 +39,7 @@ class WiFiSettings {
   IPAddress dnsIP1;
   IPAddress dnsIP2;
 
-  static void read(WiFiSettings& settings, JsonObject& root) {
+  static void read(const WiFiSettings& settings, JsonObject& root) {
     // connection settings
     root["ssid"] = settings.ssid;
     root["password"] = settings.password;
@@ -0,0 +1,21 @@
+#include <WsClientsStatus.h>
+
+WsClientsStatus::WsClientsStatus(AsyncWebServer* server, SecurityManager* securityManager, MultiWsManager* wsManager) :
+    _wsManager(wsManager) {
+  server->on(WS_CLIENTS_STATUS_SERVICE_PATH,
+             HTTP_GET,
+             securityManager->wrapRequest(std::bind(&WsClientsStatus::wsClientsStatus, this, std::placeholders::_1),
+                                          AuthenticationPredicates::IS_AUTHENTICATED));
+}
+
+void WsClientsStatus::wsClientsStatus(AsyncWebServerRequest* request) {
+  // endpoint paths are linked, not copied
+  size_t entries = _wsManager->clientCount();
+  AsyncJsonResponse* response =
+      new AsyncJsonResponse(false, JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(entries) + entries * JSON_OBJECT_SIZE(8));
+  JsonObject root = response->getRoot();
+  JsonArray clients = root.createNestedArray("clients");
+  _wsManager->clientStats(clients);
+  response->setLength();
+  request->send(response);
+}
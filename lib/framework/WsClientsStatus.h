@@ -0,0 +1,25 @@
+#ifndef WsClientsStatus_h
+#define WsClientsStatus_h
+
+#include <ArduinoJson.h>
+#include <AsyncJson.h>
+#include <ESPAsyncWebServer.h>
+#include <NewMultiWsService.h>
+#include <SecurityManager.h>
+
+#define WS_CLIENTS_STATUS_SERVICE_PATH "/rest/wsClients"
+
+/**
+ * Reports RTT, send queue depth and the derived state interval of every WebSocket client, see MultiWsManager.
+ */
+class WsClientsStatus {
+ public:
+  WsClientsStatus(AsyncWebServer* server, SecurityManager* securityManager, MultiWsManager* wsManager);
+
+ private:
+  MultiWsManager* _wsManager;
+
+  void wsClientsStatus(AsyncWebServerRequest* request);
+};
+
+#endif  // end WsClientsStatus_h
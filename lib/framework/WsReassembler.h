@@ -0,0 +1,191 @@
+#ifndef WsReassembler_h
+#define WsReassembler_h
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+#include <map>
+
+// Largest text message a client may send, longer ones are discarded as a whole
+#ifndef WS_MAX_MESSAGE_SIZE
+#define WS_MAX_MESSAGE_SIZE 4096
+#endif
+
+// Bytes all partial messages of one socket may hold together, the least recently fed is evicted to make room
+#ifndef WS_REASSEMBLY_BUDGET
+#define WS_REASSEMBLY_BUDGET 8192
+#endif
+
+// A partial message not continued for this long is evicted before any other
+#ifndef WS_REASSEMBLY_TIMEOUT_MS
+#define WS_REASSEMBLY_TIMEOUT_MS 5000
+#endif
+
+/**
+ * Reassembles text messages that arrive in several WS_EVT_DATA events, either because TCP split a frame (index > 0)
+ * or because the client sent continuation frames.
+ *
+ * A message in one piece is handed out without copying into a buffer. Otherwise the pieces are appended to a buffer
+ * per client, and the message is handed out once the final frame is complete. A message longer than maxMessageSize is
+ * discarded up to its end. The buffers of all clients share the budget; when it is exhausted, stale and then least
+ * recently fed buffers are evicted, and if that is not enough the new piece is discarded. All calls must come from the
+ * AsyncTCP task that delivers the events.
+ */
+class WsReassembler {
+ public:
+  WsReassembler(size_t maxMessageSize = WS_MAX_MESSAGE_SIZE, size_t budget = WS_REASSEMBLY_BUDGET) :
+      _maxMessageSize(maxMessageSize), _budget(budget), _bytes(0), _peak(0), _dropped(0), _evicted(0) {
+  }
+
+  // feeds one data event, returns true with the complete text message in message
+  bool feed(uint32_t clientId, const AwsFrameInfo* info, const uint8_t* data, size_t len, String* message) {
+    bool first = info->index == 0 && info->opcode != WS_CONTINUATION;
+    bool last = info->final && info->index + len == info->len;
+    auto existing = _partial.find(clientId);
+
+    if (first) {
+      // a new message replaces whatever the client left unfinished
+      if (existing != _partial.end()) {
+        release(existing);
+        existing = _partial.end();
+      }
+      if (info->message_opcode != WS_TEXT) {
+        return false;
+      }
+      if (last) {
+        if (len > _maxMessageSize) {
+          _dropped++;
+          return false;
+        }
+        *message = String((const char*)data, len);
+        return true;
+      }
+      existing = _partial.emplace(clientId, Partial()).first;
+      if (info->len > _maxMessageSize) {
+        existing->second.discard = true;
+      } else {
+        reserve(existing, info->len);
+      }
+    } else if (existing == _partial.end()) {
+      // continuation of a discarded, evicted or binary message
+      return false;
+    }
+
+    Partial& partial = existing->second;
+    partial.touched = millis();
+    if (!partial.discard && partial.text.length() + len > _maxMessageSize) {
+      partial.discard = true;
+    }
+    if (!partial.discard && !reserve(existing, partial.text.length() + len)) {
+      partial.discard = true;
+    }
+    if (partial.discard) {
+      // keeps the entry so the rest of the message is recognised and skipped, but not its memory
+      if (partial.reserved) {
+        _bytes -= partial.reserved;
+        partial.reserved = 0;
+        partial.text = String();
+      }
+    } else {
+      partial.text.concat((const char*)data, len);
+    }
+    if (!last) {
+      return false;
+    }
+    bool complete = !partial.discard;
+    if (complete) {
+      *message = partial.text;
+    } else {
+      _dropped++;
+    }
+    release(existing);
+    return complete;
+  }
+
+  // drops the partial message of a client that disconnected
+  void erase(uint32_t clientId) {
+    auto existing = _partial.find(clientId);
+    if (existing != _partial.end()) {
+      release(existing);
+    }
+  }
+
+  size_t bytes() const {
+    return _bytes;
+  }
+  size_t peak() const {
+    return _peak;
+  }
+  uint32_t dropped() const {
+    return _dropped;
+  }
+  uint32_t evicted() const {
+    return _evicted;
+  }
+
+ private:
+  struct Partial {
+    String text;
+    size_t reserved = 0;
+    unsigned long touched = 0;
+    bool discard = false;
+  };
+
+  size_t _maxMessageSize;
+  size_t _budget;
+  size_t _bytes;
+  size_t _peak;
+  uint32_t _dropped;
+  uint32_t _evicted;
+  std::map<uint32_t, Partial> _partial;
+
+  // accounts for the buffer growing to size, evicting other partial messages if the budget requires it
+  bool reserve(std::map<uint32_t, Partial>::iterator target, size_t size) {
+    Partial& partial = target->second;
+    if (size <= partial.reserved) {
+      return true;
+    }
+    size_t growth = size - partial.reserved;
+    while (_bytes + growth > _budget && evictOne(target->first)) {
+    }
+    if (_bytes + growth > _budget || !partial.text.reserve(size)) {
+      return false;
+    }
+    partial.reserved = size;
+    _bytes += growth;
+    if (_bytes > _peak) {
+      _peak = _bytes;
+    }
+    return true;
+  }
+
+  bool evictOne(uint32_t keep) {
+    unsigned long now = millis();
+    auto victim = _partial.end();
+    for (auto it = _partial.begin(); it != _partial.end(); ++it) {
+      if (it->first == keep || !it->second.reserved) {
+        continue;
+      }
+      if (now - it->second.touched > WS_REASSEMBLY_TIMEOUT_MS) {
+        victim = it;
+        break;
+      }
+      if (victim == _partial.end() || now - it->second.touched > now - victim->second.touched) {
+        victim = it;
+      }
+    }
+    if (victim == _partial.end()) {
+      return false;
+    }
+    _evicted++;
+    release(victim);
+    return true;
+  }
+
+  void release(std::map<uint32_t, Partial>::iterator partial) {
+    _bytes -= partial->second.reserved;
+    _partial.erase(partial);
+  }
+};
+
+#endif  // end WsReassembler_h
@@ -0,0 +1,84 @@
+#ifndef WsTokenBucket_h
+#define WsTokenBucket_h
+
+#include <Arduino.h>
+
+/**
+ * Token bucket for outgoing WebSocket state frames.
+ *
+ * Up to `burst` frames go out back to back, after that one token is refilled every `intervalMs`. A frame that finds
+ * the bucket empty is not dropped by the caller: it remembers that a send is pending and flushes it after waitMs(),
+ * so the last change of a burst always reaches the client within one interval. An interval of 0 disables limiting.
+ */
+class WsTokenBucket {
+ public:
+  WsTokenBucket(uint8_t burst = 1, uint32_t intervalMs = 0) {
+    configure(burst, intervalMs);
+  }
+
+  void configure(uint8_t burst, uint32_t intervalMs) {
+    _burst = burst ? burst : 1;
+    _intervalMs = intervalMs;
+    _tokens = _burst;
+    _lastRefill = millis();
+  }
+
+  bool limited() const {
+    return _intervalMs > 0;
+  }
+  uint8_t burst() const {
+    return _burst;
+  }
+  uint32_t intervalMs() const {
+    return _intervalMs;
+  }
+
+  // takes a token if one is available
+  bool tryAcquire(unsigned long now) {
+    if (!limited()) {
+      return true;
+    }
+    refill(now);
+    if (!_tokens) {
+      return false;
+    }
+    _tokens--;
+    return true;
+  }
+
+  // milliseconds until the next token, 0 if one is available
+  uint32_t waitMs(unsigned long now) {
+    if (!limited()) {
+      return 0;
+    }
+    refill(now);
+    if (_tokens) {
+      return 0;
+    }
+    unsigned long elapsed = now - _lastRefill;
+    return elapsed >= _intervalMs ? 0 : _intervalMs - elapsed;
+  }
+
+ private:
+  uint8_t _burst;
+  uint8_t _tokens;
+  uint32_t _intervalMs;
+  unsigned long _lastRefill;
+
+  void refill(unsigned long now) {
+    unsigned long elapsed = now - _lastRefill;
+    if (elapsed < _intervalMs) {
+      return;
+    }
+    unsigned long earned = elapsed / _intervalMs;
+    if (_tokens + earned >= _burst) {
+      _tokens = _burst;
+      _lastRefill = now;
+    } else {
+      _tokens += earned;
+      _lastRefill += earned * _intervalMs;
+    }
+  }
+};
+
+#endif  // end WsTokenBucket_h
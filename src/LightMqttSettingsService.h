@@ -14,7 +14,7 @@ class LightMqttSettings {
   String name;
   String uniqueId;
 
-  static void read(LightMqttSettings& settings, JsonObject& root) {
+  static void read(const LightMqttSettings& settings, JsonObject& root) {
     root["mqtt_path"] = settings.mqttPath;
     root["name"] = settings.name;
     root["unique_id"] = settings.uniqueId;
@@ -12,6 +12,16 @@ LightStateService::LightStateService(AsyncWebServer*  server,
                 this, server,
                 LIGHT_SETTINGS_ENDPOINT_PATH,
                 sm, AuthenticationPredicates::IS_AUTHENTICATED)
+, _formStream  (LightState::stream,
+                this, server,
+                LIGHT_SETTINGS_ENDPOINT_PATH,
+                sm, AuthenticationPredicates::IS_AUTHENTICATED)
+, _formSchema  (LightState::read,
+                LightState::values,
+                this, server,
+                LIGHT_SETTINGS_SCHEMA_PATH,
+                LIGHT_SETTINGS_VALUES_PATH,
+                sm, AuthenticationPredicates::IS_AUTHENTICATED)
 , _mqttPubSub  (LightState::haRead, LightState::haUpdate, this, mqtt)
 , _mqttClient  (mqtt)
 , _lightMqttSettingsService(lms)
@@ -21,13 +31,34 @@ LightStateService::LightStateService(AsyncWebServer*  server,
     pinMode(LED_PIN, OUTPUT);
     _mqttClient->onConnect(std::bind(&LightStateService::registerConfig,this));
     _lightMqttSettingsService->addUpdateHandler([&](const String&){registerConfig();},false);
-    _wsManager->addEndpoint<LightState>(LIGHT_SETTINGS_SOCKET_PATH,this,LightState::readSta,LightState::updateSta);
-    addUpdateHandler([this](const String& origin){_wsManager->broadcastCurrentState(LIGHT_SETTINGS_SOCKET_PATH, origin);
+    _wsEndpoint = _wsManager->addEndpoint<LightState>(LIGHT_SETTINGS_SOCKET_PATH,this,LightState::readSta,LightState::updateSta);
+    _wsManager->setFieldKeys(LIGHT_SETTINGS_SOCKET_PATH, {
+        {"trend_data",    LightState::F_RUNTIME},
+        {"test_number",   LightState::F_RUNTIME},
+        {"test_checkbox", LightState::F_RUNTIME},
+        {"test_switch",   LightState::F_RUNTIME},
+        {"test_text",     LightState::F_TEST_TEXT},
+        {"test_textarea", LightState::F_TEXT_AREA},
+        {"test_dropdown", LightState::F_TEST_DROPDOWN},
+    });
+    // ключі, які показує кожна форма (див. LightState::read) — для {"type":"sub","forms":[...]}
+    const std::vector<String> formKeys = {"trend_data", "led_on", "test_text", "test_number", "test_checkbox",
+                                          "test_switch", "test_dropdown", "test_textarea", "gain"};
+    _wsManager->setFormKeys(LIGHT_SETTINGS_SOCKET_PATH, "status",   formKeys);
+    _wsManager->setFormKeys(LIGHT_SETTINGS_SOCKET_PATH, "settings", formKeys);
+    // trend_data змінюється щосекунди, решту полів клієнти отримують лише при зміні
+    _wsManager->setDeltaMode(LIGHT_SETTINGS_SOCKET_PATH);
+    addChangeHandler([this](const String& origin, state_change_mask_t changed){
+        _wsManager->broadcastCurrentState(_wsEndpoint, origin, changed);
     },false);
+    // у HA публікується лише стан LED
+    _mqttPubSub.setPublishedFields(LightState::F_LED_ON);
 }
 
 void LightStateService::begin() {
   _state.ledOn = DEFAULT_LED_STATE;
+  // GET /rest/lightState, WS та MQTT читають копію стану без mutex
+  enableSnapshots();
 
   // Запускаємо фоновий task
   xTaskCreatePinnedToCore(
@@ -75,7 +106,7 @@ void LightStateService::registerConfig() {
 void LightStateService::lightTask(void* pvParameters) {
   LightStateService* service = static_cast<LightStateService*>(pvParameters);
   while (true) {
-    service->callUpdateHandlers("lightTask");  // Викликати оновлення для WS
+    service->callUpdateHandlers("lightTask", LightState::F_RUNTIME);  // Викликати оновлення для WS (лише runtime-поля)
     vTaskDelay(pdMS_TO_TICKS(1000));  // Приклад — 1s
   }
 }
\ No newline at end of file
@@ -9,6 +9,9 @@
 #include <NTPSettingsService.h>
 #include <SunRise.h>
 #include <FormBuilder.h>
+#include <FormSchemaEndpoint.h>
+#include <FormStream.h>
+#include <FieldBindings.h>
 #include <NewMultiWsService.h>  // <-- Містить MultiWsManager
 
 #define LED_PIN 2
@@ -28,9 +31,25 @@
 
 #define LIGHT_SETTINGS_ENDPOINT_PATH "/rest/lightState"
 #define LIGHT_SETTINGS_SOCKET_PATH   "/ws/lightState"
+// схема форм (з ETag) і їхні значення окремо; не під LIGHT_SETTINGS_ENDPOINT_PATH — той шлях перехопив би їх
+#define LIGHT_SETTINGS_SCHEMA_PATH   "/rest/lightStateSchema"
+#define LIGHT_SETTINGS_VALUES_PATH   "/rest/lightStateValues"
 
 class LightState {
  public:
+  // ---------- Біти полів для масок змін (див. StateChangeRecorder) ----------
+  enum Field : state_change_mask_t {
+    F_LED_ON        = 1u << 0,
+    F_MONTHLY_LIMIT = 1u << 1,
+    F_DAILY_LIMIT   = 1u << 2,
+    F_TEST_NUMBER   = 1u << 3,
+    F_TEST_DROPDOWN = 1u << 4,
+    F_GAIN          = 1u << 5,
+    F_TEST_TEXT     = 1u << 6,
+    F_TEXT_AREA     = 1u << 7,
+    F_RUNTIME       = 1u << 8,  // trend_data та згенеровані test_number/test_checkbox/test_switch
+  };
+
   bool   ledOn{DEFAULT_LED_STATE};
   float  monthlyConsumptionLimit{0.0f};  // kWh
   float  dailyConsumptionLimit{0.0f};    // kWh
@@ -41,8 +60,25 @@ class LightState {
   String testText;
   String textArea{"Millis are: "};
 
+  // ---------- Ключі стану: ключ → член і біт маски (REST/WS update, values) ----------
+  // Форми лишаються ручними: вони показують кілька віджетів на один ключ (R і RW, демо-значення).
+  static const FieldTable<LightState>& fields() {
+    static const FieldBinding<LightState> bindings[] = {
+      {"test_text",                 &LightState::testText,                F_TEST_TEXT},
+      {"monthly_consumption_limit", &LightState::monthlyConsumptionLimit, F_MONTHLY_LIMIT},
+      {"daily_consumption_limit",   &LightState::dailyConsumptionLimit,   F_DAILY_LIMIT},
+      {"led_on",                    &LightState::ledOn,                   F_LED_ON},  // bool only
+      {"test_number",               &LightState::testNumber,              F_TEST_NUMBER},
+      {"test_dropdown",             &LightState::testDropdown,            F_TEST_DROPDOWN},
+      {"test_textarea",             &LightState::textArea,                F_TEXT_AREA},
+      {"gain",                      &LightState::gain,                    F_GAIN},
+    };
+    static const FieldTable<LightState> table(bindings);
+    return table;
+  }
+
   // ---------- Генерація WS-стану (trend + тестові поля) ----------
-  static void readSta(LightState& st, JsonObject& root) {
+  static void readSta(const LightState& st, JsonObject& root) {
     /* -------------------------------------------------
      *  Конфігурація генератора
      * ------------------------------------------------*/
@@ -139,123 +175,92 @@ class LightState {
 
   // ---------- WS update (тільки boolean для булевих) ----------
   static StateUpdateResult updateSta(JsonObject& root, LightState& lightState) {
-    bool stateChanged = false;
     Serial.println("Received WS object:");
     serializeJsonPretty(root, Serial);
+    return fields().update(root, lightState);
+  }
 
-    stateChanged |= FormBuilder::updateValue(root, "test_text",      lightState.testText);
-    stateChanged |= FormBuilder::updateValue(root, "monthly_consumption_limit", lightState.monthlyConsumptionLimit);
-    stateChanged |= FormBuilder::updateValue(root, "daily_consumption_limit",   lightState.dailyConsumptionLimit);
-    stateChanged |= FormBuilder::updateValue(root, "led_on",         lightState.ledOn);       // bool only
-    stateChanged |= FormBuilder::updateValue(root, "test_number",    lightState.testNumber);
-    stateChanged |= FormBuilder::updateValue(root, "test_dropdown",  lightState.testDropdown);
-    stateChanged |= FormBuilder::updateValue(root, "test_textarea",  lightState.textArea);
-    stateChanged |= FormBuilder::updateValue(root, "gain",           lightState.gain);
+  // ---------- Видача форм (REST) ----------
+  static void read(const LightState& s, JsonObject& root) {
+    FormDocumentWriter form(root);
+    forms(s, form);
+  }
 
-    return stateChanged ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
+  // Ті самі форми потоком, без документа (GET LIGHT_SETTINGS_ENDPOINT_PATH)
+  static void stream(const LightState& s, FormStreamWriter& form) {
+    forms(s, form);
   }
 
-  // ---------- Видача форм (REST) ----------
-  static void read(LightState& s, JsonObject& root) {
-    JsonArray sta = FormBuilder::createForm(root, "status", "Status Form");
-    FormBuilder::addTrendField(sta, "trend_data", AF::RW,
-      lines(line("key1", hidden, "#8884d8", "monotone"),
-            line("key2", hidden, "#FF0000", "monotone"),
-            line("key3", hidden, "#FF00FF", "monotone")),
-      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("lineChart"));
-
-    FormBuilder::addTrendField(sta, "trend_data", AF::RW,
-      lines(line("key1", hidden, "#8884d8", "monotone"),
-            line("key2", hidden, "#FF0000", "monotone"),
-            line("key3", hidden, "#FF00FF", "monotone")),
-      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("barChart"));
-
-    FormBuilder::addTrendField(sta, "trend_data", AF::RW,
-      lines(line("key1",  visible, "#8884d8", "monotone"),
-            line("key2",  hidden,  "#FF0000", "step"),
-            line("key3",  visible, "#FF00FF", "monotone"),
-            line("key21", visible, "#556B2F", "monotone")),
-      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("pieChart"));
-
-    FormBuilder::addSwitchField  (sta, "led_on",       AF::RW, s.ledOn);
-    FormBuilder::addSwitchField  (sta, "led_on",       AF::R,  s.ledOn);
-    FormBuilder::addTextField    (sta, "test_text",    AF::RW, "Sample text from Medved");
-    FormBuilder::addTextField    (sta, "test_text",    AF::R,  "Sample text from Medved");
-    FormBuilder::addNumberField  (sta, "test_number",  AF::RW, (double)s.testNumber, minVal(0), maxVal(100), format("0.00"));
-    FormBuilder::addNumberField  (sta, "test_number",  AF::R,  (double)s.testNumber, minVal(0), maxVal(100), format("0.00"));
-    FormBuilder::addCheckboxField(sta, "test_checkbox",AF::RW, s.ledOn);
-    FormBuilder::addCheckboxField(sta, "test_checkbox",AF::R,  s.ledOn);
-    FormBuilder::addSwitchField  (sta, "test_switch",  AF::RW, s.ledOn);
-    FormBuilder::addSwitchField  (sta, "test_switch",  AF::R,  s.ledOn);
-    FormBuilder::addDropdownField(sta, "test_dropdown",AF::RW, s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option",3));
-    FormBuilder::addDropdownField(sta, "test_dropdown",AF::R,  s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option",3));
-    FormBuilder::addRadioField   (sta, "test_dropdown",AF::RW, s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option bla bla bla",3));
-    FormBuilder::addRadioField   (sta, "test_dropdown",AF::R,  s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option bla bla bla",3));
-    FormBuilder::addTextareaField(sta, "test_textarea",AF::RW, s.textArea);
-    FormBuilder::addTextareaField(sta, "test_textarea",AF::R,  s.textArea);
-    FormBuilder::addSliderField  (sta, "gain",        AF::RW, s.gain, minVal(10), maxVal(60));
-    FormBuilder::addSliderField  (sta, "gain",        AF::R,  s.gain, minVal(10), maxVal(60));
-
-    JsonArray set = FormBuilder::createForm(root, "settings", "Settings Form");
-    FormBuilder::addTrendField(set, "trend_data", AF::RW,
-      lines(line("key1", hidden, "#8884d8", "monotone"),
-            line("key2", hidden, "#FF0000", "monotone"),
-            line("key3", hidden, "#FF00FF", "monotone")),
-      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("lineChart"));
-
-    FormBuilder::addTrendField(set, "trend_data", AF::RW,
-      lines(line("key1", hidden, "#8884d8", "monotone"),
-            line("key2", hidden, "#FF0000", "monotone"),
-            line("key3", hidden, "#FF00FF", "monotone")),
-      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("barChart"));
-
-    FormBuilder::addTrendField(set, "trend_data", AF::RW,
-      lines(line("key1",  visible, "#8884d8", "monotone"),
-            line("key2",  hidden,  "#FF0000", "step"),
-            line("key3",  visible, "#FF00FF", "monotone"),
-            line("key21", visible, "#556B2F", "monotone")),
-      xAxis("timestamp"), legend(true), tooltip(true), trendMaxPoints(120), mode("pieChart"));
-
-    FormBuilder::addSwitchField  (set, "led_on",       AF::RW, s.ledOn);
-    FormBuilder::addSwitchField  (set, "led_on",       AF::R,  s.ledOn);
-    FormBuilder::addTextField    (set, "test_text",    AF::RW, "Sample text from Medved");
-    FormBuilder::addTextField    (set, "test_text",    AF::R,  "Sample text from Medved");
-    FormBuilder::addNumberField  (set, "test_number",  AF::RW, (double)s.testNumber, minVal(0), maxVal(100), format("0.00"));
-    FormBuilder::addNumberField  (set, "test_number",  AF::R,  (double)s.testNumber, minVal(0), maxVal(100), format("0.00"));
-    FormBuilder::addCheckboxField(set, "test_checkbox",AF::RW, s.ledOn);
-    FormBuilder::addCheckboxField(set, "test_checkbox",AF::R,  s.ledOn);
-    FormBuilder::addSwitchField  (set, "test_switch",  AF::RW, s.ledOn);
-    FormBuilder::addSwitchField  (set, "test_switch",  AF::R,  s.ledOn);
-    FormBuilder::addDropdownField(set, "test_dropdown",AF::RW, s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option",3));
-    FormBuilder::addDropdownField(set, "test_dropdown",AF::R,  s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option",3));
-    FormBuilder::addRadioField   (set, "test_dropdown",AF::RW, s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option bla bla bla",3));
-    FormBuilder::addRadioField   (set, "test_dropdown",AF::R,  s.testDropdown, opt("Option1",1), opt("Option2",2), opt("Third option bla bla bla",3));
-    FormBuilder::addTextareaField(set, "test_textarea",AF::RW, s.textArea);
-    FormBuilder::addTextareaField(set, "test_textarea",AF::R,  s.textArea);
-    FormBuilder::addSliderField  (set, "gain",        AF::RW, s.gain, minVal(10), maxVal(60));
-    FormBuilder::addSliderField  (set, "gain",        AF::R,  s.gain, minVal(10), maxVal(60));
+  template <class Form>
+  static void forms(const LightState& s, Form& f) {
+    f.createForm("status", "Status Form");
+    addFields(s, f);
+    f.createForm("settings", "Settings Form");
+    addFields(s, f);
+  }
+
+  template <class Form>
+  static void addFields(const LightState& s, Form& f) {
+    f.addTrendField("trend_data",
+      FB_O(FB_TREND, FB_RW, FB_MODE("lineChart") FB_XAXIS("timestamp")
+           FB_LINES(FB_HIDDEN_LINE("key1", "#8884d8", "monotone") FB_LINE_SEP
+                    FB_HIDDEN_LINE("key2", "#FF0000", "monotone") FB_LINE_SEP
+                    FB_HIDDEN_LINE("key3", "#FF00FF", "monotone"))
+           FB_LEGEND FB_TOOLTIP FB_MAX_POINTS(120)));
+
+    f.addTrendField("trend_data",
+      FB_O(FB_TREND, FB_RW, FB_MODE("barChart") FB_XAXIS("keys")
+           FB_LINES(FB_HIDDEN_LINE("key1", "#8884d8", "monotone") FB_LINE_SEP
+                    FB_HIDDEN_LINE("key2", "#FF0000", "monotone") FB_LINE_SEP
+                    FB_HIDDEN_LINE("key3", "#FF00FF", "monotone"))
+           FB_LEGEND FB_TOOLTIP FB_MAX_POINTS(120)));
+
+    f.addTrendField("trend_data",
+      FB_O(FB_TREND, FB_RW, FB_MODE("pieChart") FB_XAXIS("timestamp")
+           FB_LINES(FB_LINE       ("key1",  "#8884d8", "monotone") FB_LINE_SEP
+                    FB_HIDDEN_LINE("key2",  "#FF0000", "step")     FB_LINE_SEP
+                    FB_LINE       ("key3",  "#FF00FF", "monotone") FB_LINE_SEP
+                    FB_LINE       ("key21", "#556B2F", "monotone"))
+           FB_LEGEND FB_TOOLTIP FB_MAX_POINTS(120)));
+
+    f.addSwitchField  ("led_on",       AF::RW, s.ledOn);
+    f.addSwitchField  ("led_on",       AF::R,  s.ledOn);
+    f.addTextField    ("test_text",    AF::RW, s.testText.c_str());
+    f.addTextField    ("test_text",    AF::R,  s.testText.c_str());
+    f.addNumberField  ("test_number",   (double)s.testNumber, FB_O(FB_NUMBER, FB_RW, FB_MIN(0) FB_MAX(100) FB_FORMAT("0.00")));
+    f.addNumberField  ("test_number",   (double)s.testNumber, FB_O(FB_NUMBER, FB_R,  FB_MIN(0) FB_MAX(100) FB_FORMAT("0.00")));
+    f.addCheckboxField("test_checkbox",AF::RW, s.ledOn);
+    f.addCheckboxField("test_checkbox",AF::R,  s.ledOn);
+    f.addSwitchField  ("test_switch",  AF::RW, s.ledOn);
+    f.addSwitchField  ("test_switch",  AF::R,  s.ledOn);
+    f.addField        ("test_dropdown", s.testDropdown, FB_O(FB_DROPDOWN, FB_RW, FB_OPTIONS("Option1,Option2,Third option")));
+    f.addField        ("test_dropdown", s.testDropdown, FB_O(FB_DROPDOWN, FB_R,  FB_OPTIONS("Option1,Option2,Third option")));
+    f.addField        ("test_dropdown", s.testDropdown, FB_O(FB_RADIO, FB_RW, FB_OPTIONS("Option1,Option2,Third option bla bla bla")));
+    f.addField        ("test_dropdown", s.testDropdown, FB_O(FB_RADIO, FB_R,  FB_OPTIONS("Option1,Option2,Third option bla bla bla")));
+    f.addTextareaField("test_textarea",AF::RW, s.textArea);
+    f.addTextareaField("test_textarea",AF::R,  s.textArea);
+    f.addField        ("gain",          s.gain, FB_O(FB_SLIDER, FB_RW, FB_MIN(10) FB_MAX(60) FB_STEP(1)));
+    f.addField        ("gain",          s.gain, FB_O(FB_SLIDER, FB_R,  FB_MIN(10) FB_MAX(60) FB_STEP(1)));
+  }
+
+  // ---------- Значення полів форм (REST, плоско key → value) з таблиці fields() ----------
+  static void values(const LightState& s, JsonObject& root) {
+    root.createNestedObject("trend_data");
+    fields().read(s, root, BIND_STATE);
+    // демо-віджети форм, що показують led_on
+    root["test_checkbox"] = s.ledOn;
+    root["test_switch"]   = s.ledOn;
   }
 
   // ---------- REST update (тільки boolean для булевих) ----------
   static StateUpdateResult update(JsonObject& root, LightState& lightState) {
-    bool stateChanged = false;
     Serial.println("Received REST object :");
     serializeJsonPretty(root, Serial);
-
-    stateChanged |= FormBuilder::updateValue(root, "test_text",      lightState.testText);
-    stateChanged |= FormBuilder::updateValue(root, "monthly_consumption_limit", lightState.monthlyConsumptionLimit);
-    stateChanged |= FormBuilder::updateValue(root, "daily_consumption_limit",   lightState.dailyConsumptionLimit);
-    stateChanged |= FormBuilder::updateValue(root, "led_on",         lightState.ledOn);       // bool only
-    stateChanged |= FormBuilder::updateValue(root, "test_number",    lightState.testNumber);
-    stateChanged |= FormBuilder::updateValue(root, "test_dropdown",  lightState.testDropdown);
-    stateChanged |= FormBuilder::updateValue(root, "test_textarea",  lightState.textArea);
-    stateChanged |= FormBuilder::updateValue(root, "gain",           lightState.gain);
-
-    return stateChanged ? StateUpdateResult::CHANGED : StateUpdateResult::UNCHANGED;
+    return fields().update(root, lightState);
   }
 
   // ---------- Home Assistant сумісність (рядки ON/OFF як і було) ----------
-  static void haRead(LightState& settings, JsonObject& root) {
+  static void haRead(const LightState& settings, JsonObject& root) {
     root["state"] = settings.ledOn ? ON_STATE : OFF_STATE;
   }
 
@@ -291,7 +296,9 @@ class LightStateService : public StatefulService<LightState> {
   void begin();
 
  private:
-  HttpEndpoint<LightState>           _httpEndpoint;
+  HttpPostEndpoint<LightState>       _httpEndpoint;
+  FormStreamEndpoint<LightState>     _formStream;
+  FormSchemaEndpoint<LightState>     _formSchema;
   MqttPubSub<LightState>             _mqttPubSub;
   AsyncMqttClient*                   _mqttClient;
   LightMqttSettingsService*          _lightMqttSettingsService;
@@ -301,6 +308,7 @@ class LightStateService : public StatefulService<LightState> {
 
   // Зберігаємо MultiWsManager
   MultiWsManager* _wsManager;
+  ws_endpoint_t   _wsEndpoint{WS_INVALID_ENDPOINT};
   String          _originId;
 
   void registerConfig();